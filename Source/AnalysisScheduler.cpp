@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    AnalysisScheduler.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalysisScheduler.h"
+
+void AnalysisScheduler::prepare(int newWindowSize, int newHopSize)
+{
+    jassert(newWindowSize > 0 && newHopSize > 0 && newHopSize <= newWindowSize);
+
+    windowSize = newWindowSize;
+    hopSize = newHopSize;
+    history.prepare(windowSize);
+    window.assign(static_cast<size_t>(windowSize), 0.0f);
+    reset();
+}
+
+void AnalysisScheduler::reset() noexcept
+{
+    history.clear();
+    std::fill(window.begin(), window.end(), 0.0f);
+    samplesSinceHop = 0;
+}
+
+bool AnalysisScheduler::push(const float* samples, int numSamples) noexcept
+{
+    jassert(numSamples <= getSamplesUntilNextHop());
+
+    history.write(&samples, numSamples);
+    samplesSinceHop += numSamples;
+
+    if (samplesSinceHop < hopSize)
+        return false;
+
+    samplesSinceHop = 0;
+    history.read(0, history.getWritePosition() - windowSize, window.data(), windowSize);
+    return true;
+}
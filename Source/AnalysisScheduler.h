@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    AnalysisScheduler.h
+
+    Sliding analysis window that is fed arbitrary-sized chunks of audio and
+    signals every hopSize samples, independent of the host's block size.
+    On each hop the newest windowSize samples are unwrapped from the ring
+    into a linear window with at most two block copies.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RingBuffer.h"
+
+class AnalysisScheduler
+{
+public:
+    AnalysisScheduler() = default;
+
+    // Allocates the history; hopSize must not exceed windowSize.
+    void prepare(int windowSize, int hopSize);
+    void reset() noexcept;
+
+    // Samples that can be pushed before the next hop boundary.
+    int getSamplesUntilNextHop() const noexcept { return hopSize - samplesSinceHop; }
+
+    // Appends at most getSamplesUntilNextHop() samples.  Returns true when this
+    // completes a hop, after which getWindow() holds the newest windowSize samples.
+    bool push(const float* samples, int numSamples) noexcept;
+
+    // Oldest to newest, windowSize samples.
+    const float* getWindow() const noexcept { return window.data(); }
+
+    int getWindowSize() const noexcept { return windowSize; }
+    int getHopSize() const noexcept { return hopSize; }
+
+private:
+    RingBuffer<float, 1> history;
+    std::vector<float> window;
+    int windowSize = 0;
+    int hopSize = 0;
+    int samplesSinceHop = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisScheduler)
+};
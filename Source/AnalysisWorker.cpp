@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    AnalysisWorker.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalysisWorker.h"
+
+AnalysisWorker::AnalysisWorker()
+    : juce::Thread("Pitch analysis")
+{
+    for (size_t i = 0; i < detectors.size(); ++i)
+        detectors[i] = PitchDetector::create((PitchDetectorType)i);
+}
+
+AnalysisWorker::~AnalysisWorker()
+{
+    release();
+}
+
+void AnalysisWorker::prepare(double sampleRate, double hopSeconds, float maxFrequency)
+{
+    stop();
+
+    const int queueSize = juce::nextPowerOfTwo((int)(sampleRate * queueSeconds));
+    queue.assign((size_t)queueSize, 0.0f);
+    fifo.setTotalSize(queueSize);
+    fifo.reset();
+
+    frontEnd.prepare(sampleRate, windowSeconds, hopSeconds);
+    for (auto& detector : detectors)
+        detector->prepare(frontEnd.getAnalysisSampleRate(), frontEnd.getWindowSize(), lowestFrequency, maxFrequency);
+    gate.prepare(frontEnd.getAnalysisSampleRate(), 0);
+    appliedRange = { lowestFrequency, maxFrequency };
+    requestedMinFrequency.store(lowestFrequency);
+    requestedMaxFrequency.store(maxFrequency);
+    numDropped.store(0);
+}
+
+void AnalysisWorker::release()
+{
+    stop();
+    queue = {};
+    fifo.setTotalSize(1);
+}
+
+void AnalysisWorker::start()
+{
+    if (isThreadRunning() || queue.empty())
+        return;
+
+    fifo.reset();
+    frontEnd.reset();
+    gate.reset();
+    estimates.reset();
+    resetPending.store(false);
+    sleeping.store(false);
+
+    // Detection is late by however long the thread takes to be scheduled, so it runs above
+    // the message thread
+    startThread(juce::Thread::Priority::high);
+}
+
+void AnalysisWorker::stop()
+{
+    stopThread(1000);
+}
+
+bool AnalysisWorker::push(const float* samples, int numSamples) noexcept
+{
+    if (fifo.getFreeSpace() < numSamples)
+    {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    {
+        const auto scope = fifo.write(numSamples);
+        std::copy(samples, samples + scope.blockSize1, queue.data() + scope.startIndex1);
+        std::copy(samples + scope.blockSize1, samples + numSamples, queue.data() + scope.startIndex2);
+    }
+
+    // Signalling takes the event's lock, so it happens once per wake-up, not per push
+    if (sleeping.exchange(false, std::memory_order_seq_cst))
+        notify();
+
+    return true;
+}
+
+void AnalysisWorker::setFrequencyRange(float minFrequency, float maxFrequency) noexcept
+{
+    requestedMinFrequency.store(minFrequency, std::memory_order_relaxed);
+    requestedMaxFrequency.store(maxFrequency, std::memory_order_relaxed);
+}
+
+void AnalysisWorker::run()
+{
+    while (!threadShouldExit())
+    {
+        if (analysePending())
+            continue;
+
+        // Announce the sleep before looking again, so a push in between either is seen
+        // here or signals the event, which then doesn't wait
+        sleeping.store(true, std::memory_order_seq_cst);
+        if (fifo.getNumReady() == 0 && !resetPending.load(std::memory_order_relaxed))
+            wait(-1);
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool AnalysisWorker::analysePending() noexcept
+{
+    if (resetPending.exchange(false, std::memory_order_relaxed))
+    {
+        frontEnd.reset();
+        estimates.write({});
+    }
+
+    const int numReady = fifo.getNumReady();
+    if (numReady == 0)
+        return false;
+
+    // The samples stay queued until the scope ends, so they are read in place
+    const auto scope = fifo.read(numReady);
+    analyse(queue.data() + scope.startIndex1, scope.blockSize1);
+    analyse(queue.data() + scope.startIndex2, scope.blockSize2);
+    return true;
+}
+
+void AnalysisWorker::analyse(const float* samples, int numSamples) noexcept
+{
+    for (int offset = 0; offset < numSamples && !threadShouldExit();)
+    {
+        const int segmentLength = juce::jmin(numSamples - offset, frontEnd.getSamplesUntilNextHop());
+        if (frontEnd.push(samples + offset, segmentLength))
+        {
+            const auto range = juce::Range<float>::between(requestedMinFrequency.load(std::memory_order_relaxed),
+                                                           requestedMaxFrequency.load(std::memory_order_relaxed));
+            if (range != appliedRange)
+            {
+                appliedRange = range;
+                for (auto& detector : detectors)
+                    detector->setFrequencyRange(juce::jmax(lowestFrequency, range.getStart()), range.getEnd());
+            }
+
+            auto& detector = *detectors[(size_t)detectorType.load(std::memory_order_relaxed)];
+            const bool audible = gate.measure(frontEnd.getWindow(), frontEnd.getWindowSize());
+            estimates.write(audible ? detector.detect(frontEnd.getWindow()) : PitchEstimate {});
+        }
+
+        offset += segmentLength;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    AnalysisWorker.h
+
+    Pitch detection on a background thread, for windows too long to analyse
+    inside the audio callback: bass and baritone voices down to
+    lowestFrequency need three periods, over twice the real-time window.
+    The audio thread pushes its detection input into a lock-free single-
+    producer, single-consumer queue and reads back the newest estimate; the
+    worker drains the queue through its own front end and detectors and
+    publishes each hop's estimate through a TripleBuffer.  Neither side
+    waits for the other, so the audio thread's cost doesn't depend on the
+    window length.  The thread runs only while started, and sleeps until
+    a push wakes it; estimates arrive one scheduling delay plus one
+    detection late, which the retune smoothing absorbs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PitchAnalysisFrontEnd.h"
+#include "PitchDetector.h"
+#include "TripleBuffer.h"
+#include "VoicingGate.h"
+
+class AnalysisWorker : private juce::Thread
+{
+public:
+    static constexpr float lowestFrequency = 30.0f;
+
+    AnalysisWorker();
+    ~AnalysisWorker() override;
+
+    // Stops the worker and allocates the queue, front end and detectors.  Not real-time safe.
+    void prepare(double sampleRate, double hopSeconds, float maxFrequency);
+    // Stops the worker and frees what prepare() allocated.
+    void release();
+
+    // Message thread.  Start and stop the thread between prepare() and release(); start()
+    // begins from an empty queue and forgets the previous estimate.
+    void start();
+    void stop();
+    bool isRunning() const noexcept { return isThreadRunning(); }
+
+    // Audio thread, only while isRunning().  Queues samples for analysis and wakes the
+    // worker if it is asleep; returns false and drops them when the worker has fallen a
+    // queue's length behind.
+    bool push(const float* samples, int numSamples) noexcept;
+
+    // Audio thread.  Take effect from the worker's next hop; the range is clamped to
+    // [lowestFrequency, the maxFrequency given to prepare()].
+    void setDetectorType(PitchDetectorType type) noexcept { detectorType.store((int)type, std::memory_order_relaxed); }
+    void setFrequencyRange(float minFrequency, float maxFrequency) noexcept;
+
+    // Audio thread.  Forgets the analysed history, e.g. after a gap in what was pushed.
+    void reset() noexcept { resetPending.store(true, std::memory_order_relaxed); }
+
+    // Audio thread.  The newest estimate the worker has published.
+    PitchEstimate getLatest() noexcept { return estimates.read(); }
+
+    uint32_t getNumDropped() const noexcept { return numDropped.load(std::memory_order_relaxed); }
+
+    // Input samples each detection covers; fixed by prepare(), so readable from any thread.
+    int getNativeWindowSize() const noexcept { return frontEnd.getNativeWindowSize(); }
+
+private:
+    static constexpr double windowSeconds = 3.0 / lowestFrequency;
+    static constexpr double queueSeconds = 0.5;
+
+    void run() override;
+    bool analysePending() noexcept;
+    void analyse(const float* samples, int numSamples) noexcept;
+
+    juce::AbstractFifo fifo { 1 };
+    std::vector<float> queue;
+    PitchAnalysisFrontEnd frontEnd;         // Worker thread only, as are the detectors and gate
+    std::array<std::unique_ptr<PitchDetector>, (size_t)PitchDetectorType::numTypes> detectors;
+    VoicingGate gate;                       // Only measures, to skip detection on silence
+    juce::Range<float> appliedRange;
+    TripleBuffer<PitchEstimate> estimates;  // Worker -> audio thread
+
+    std::atomic<int> detectorType { 0 };
+    std::atomic<float> requestedMinFrequency { lowestFrequency };
+    std::atomic<float> requestedMaxFrequency { 1000.0f };
+    std::atomic<bool> resetPending { false };
+    std::atomic<bool> sleeping { false };   // Set by the worker before it waits, cleared by whoever wakes it
+    std::atomic<uint32_t> numDropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisWorker)
+};
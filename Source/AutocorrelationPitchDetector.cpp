@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    AutocorrelationPitchDetector.cpp
+
+  ==============================================================================
+*/
+
+#include "AutocorrelationPitchDetector.h"
+
+void AutocorrelationPitchDetector::prepare(double newSampleRate, int newWindowSize, float minFrequency, float maxFrequency)
+{
+    sampleRate = newSampleRate;
+    windowSize = newWindowSize;
+    prepareLags(sampleRate, windowSize, minFrequency, maxFrequency);
+
+    autocorrelator.prepare(windowSize);
+    windowed.assign(static_cast<size_t>(windowSize), 0.0f);
+    autocorr.assign(static_cast<size_t>(windowSize), 0.0f);
+
+    hannWindow.resize(static_cast<size_t>(windowSize));
+    for (int i = 0; i < windowSize; ++i)
+        hannWindow[(size_t)i] = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * i / (windowSize - 1)));
+
+    computeCorrection(hannWindow.data(), windowCorrection);
+
+    // Spectra from elsewhere were windowed by a periodic Hann, which ends one sample short
+    // of zero; scratch for its samples is the windowed buffer, unused until detect()
+    for (int i = 0; i < windowSize; ++i)
+        windowed[(size_t)i] = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * i / windowSize));
+    computeCorrection(windowed.data(), spectrumCorrection);
+}
+
+void AutocorrelationPitchDetector::computeCorrection(const float* window, std::vector<float>& correction)
+{
+    // Dividing by the window's own autocorrelation removes the taper's bias towards short lags
+    correction.assign(static_cast<size_t>(windowSize), 0.0f);
+    autocorrelator.process(window, windowSize, correction.data());
+    for (int lag = lags.getEnd() + 1; lag >= 1; --lag)
+        correction[(size_t)lag] = correction[0] / correction[(size_t)lag];
+    correction[0] = 1.0f;
+}
+
+PitchEstimate AutocorrelationPitchDetector::detect(const float* window) noexcept
+{
+    juce::FloatVectorOperations::multiply(windowed.data(), window, hannWindow.data(), windowSize);
+    autocorrelator.process(windowed.data(), windowSize, autocorr.data());
+    return findPeak(windowCorrection.data());
+}
+
+PitchEstimate AutocorrelationPitchDetector::detectFromSpectrum(const float* spectrum, float windowedEnergy) noexcept
+{
+    autocorrelator.processSpectrum(spectrum, windowedEnergy, windowSize, autocorr.data());
+    return findPeak(spectrumCorrection.data());
+}
+
+PitchEstimate AutocorrelationPitchDetector::findPeak(const float* correction) noexcept
+{
+    float* r = autocorr.data();
+    if (r[0] <= 0.0f)
+        return {};
+
+    juce::FloatVectorOperations::multiply(r, correction, lags.getEnd() + 2);
+
+    // Skip the main lobe around lag 0 so the search doesn't lock onto its falling edge
+    int lag = lags.getStart();
+    while (lag < lags.getEnd() && r[lag] > r[lag + 1])
+        ++lag;
+
+    const int firstLag = lag;
+    float highest = threshold * r[0];
+    for (; lag < lags.getEnd(); ++lag)
+        if (r[lag] > highest && r[lag] >= r[lag - 1] && r[lag] >= r[lag + 1])
+            highest = r[lag];
+
+    // Unbiased peaks at multiples of the period are nearly equal, so take the first one
+    // close to the highest rather than the argmax to avoid subharmonic errors
+    int bestLag = 0;
+    for (lag = firstLag; lag < lags.getEnd() && highest > threshold * r[0]; ++lag)
+    {
+        if (r[lag] >= peakRatio * highest && r[lag] >= r[lag - 1] && r[lag] >= r[lag + 1])
+        {
+            bestLag = lag;
+            break;
+        }
+    }
+
+    if (bestLag == 0)
+        return {};
+
+    const float period = bestLag + parabolicOffset(r[bestLag - 1], r[bestLag], r[bestLag + 1]);
+    return { static_cast<float>(sampleRate / period), juce::jlimit(0.0f, 1.0f, r[bestLag] / r[0]) };
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    AutocorrelationPitchDetector.h
+
+    Hann-windowed autocorrelation, corrected for the window's taper, with a
+    relative energy threshold and parabolic peak refinement.  Cheapest engine,
+    most prone to octave errors.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PitchDetector.h"
+#include "FFTAutocorrelator.h"
+
+class AutocorrelationPitchDetector : public PitchDetector
+{
+public:
+    void prepare(double sampleRate, int windowSize, float minFrequency, float maxFrequency) override;
+    PitchEstimate detect(const float* window) noexcept override;
+    const char* getName() const noexcept override { return "Autocorrelation"; }
+
+    // Detects from a spectrum computed elsewhere, e.g. by the phase vocoder, saving the
+    // forward transform.  The spectrum must be getFFTSize() points of the window weighted
+    // by a periodic Hann (cos(2 pi i / N), as the vocoder uses) and zero-padded;
+    // windowedEnergy is the energy of the windowed samples.
+    PitchEstimate detectFromSpectrum(const float* spectrum, float windowedEnergy) noexcept;
+    int getFFTSize() const noexcept { return autocorrelator.getFFTSize(); }
+
+private:
+    PitchEstimate findPeak(const float* correction) noexcept;
+    void computeCorrection(const float* window, std::vector<float>& correction);
+
+    static constexpr float threshold = 0.1f;   // Peak must exceed this fraction of r[0]
+    static constexpr float peakRatio = 0.9f;   // Choose the first peak within this ratio of the highest
+
+    FFTAutocorrelator autocorrelator;
+    std::vector<float> hannWindow;
+    std::vector<float> windowCorrection;        // r_w[0] / r_w[lag] for hannWindow, used by detect()
+    std::vector<float> spectrumCorrection;      // The same for the periodic Hann of detectFromSpectrum()
+    std::vector<float> windowed;
+    std::vector<float> autocorr;
+    double sampleRate = 44100.0;
+    int windowSize = 0;
+};
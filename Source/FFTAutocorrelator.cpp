@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    FFTAutocorrelator.cpp
+
+  ==============================================================================
+*/
+
+#include "FFTAutocorrelator.h"
+
+void FFTAutocorrelator::prepare(int newMaxWindowSize)
+{
+    jassert(newMaxWindowSize > 0);
+
+    // Padding to >= 2N keeps the circular correlation from wrapping onto the lags we read
+    int order = 1;
+    while ((1 << order) < 2 * newMaxWindowSize)
+        ++order;
+
+    maxWindowSize = newMaxWindowSize;
+    fftSize = 1 << order;
+    fft = std::make_unique<juce::dsp::FFT>(order);
+    fftData.assign(static_cast<size_t>(2 * fftSize), 0.0f);
+}
+
+void FFTAutocorrelator::process(const float* input, int numSamples, float* output) noexcept
+{
+    jassert(fft != nullptr && numSamples <= maxWindowSize);
+
+    auto* data = fftData.data();
+    juce::FloatVectorOperations::copy(data, input, numSamples);
+    juce::FloatVectorOperations::clear(data + numSamples, 2 * fftSize - numSamples);
+
+    float energy = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+        energy += input[i] * input[i];
+
+    fft->performRealOnlyForwardTransform(data, true);
+    processSpectrum(data, energy, numSamples, output);
+}
+
+void FFTAutocorrelator::processSpectrum(const float* spectrum, float energy, int numSamples, float* output) noexcept
+{
+    jassert(fft != nullptr && numSamples <= maxWindowSize);
+
+    if (energy <= 0.0f)
+    {
+        juce::FloatVectorOperations::clear(output, numSamples);
+        return;
+    }
+
+    // Power spectrum: |X[k]|^2 in the real slot, zero imaginary part.  Safe in place.
+    auto* data = fftData.data();
+    for (int k = 0; k <= fftSize / 2; ++k)
+    {
+        const float re = spectrum[2 * k];
+        const float im = spectrum[2 * k + 1];
+        data[2 * k] = re * re + im * im;
+        data[2 * k + 1] = 0.0f;
+    }
+
+    fft->performRealOnlyInverseTransform(data);
+
+    // Rescale so r[0] equals the window energy, independent of the FFT backend's scaling
+    const float scale = data[0] > 0.0f ? energy / data[0] : 0.0f;
+    juce::FloatVectorOperations::copyWithMultiply(output, data, scale, numSamples);
+}
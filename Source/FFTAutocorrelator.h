@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    FFTAutocorrelator.h
+
+    Computes the linear autocorrelation of a window via the Wiener-Khinchin
+    theorem: zero-pad to at least twice the window, take the power spectrum,
+    and transform back.  All FFT plans and scratch are allocated in prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class FFTAutocorrelator
+{
+public:
+    FFTAutocorrelator() = default;
+
+    // Allocates the FFT plan and scratch for windows of up to maxWindowSize samples.
+    void prepare(int maxWindowSize);
+
+    // Writes r[lag] = sum(x[i] * x[i + lag]) for lag in [0, numSamples) into output.
+    // numSamples must not exceed the size passed to prepare().  Allocation-free.
+    void process(const float* input, int numSamples, float* output) noexcept;
+
+    // Same result as process(), for callers that already hold the forward transform of
+    // the zero-padded input: getFFTSize() points, in the interleaved layout written by
+    // juce::dsp::FFT::performRealOnlyForwardTransform.  energy is sum(x[i]^2).
+    void processSpectrum(const float* spectrum, float energy, int numSamples, float* output) noexcept;
+
+    int getMaxWindowSize() const noexcept { return maxWindowSize; }
+    int getFFTSize() const noexcept { return fftSize; }
+
+private:
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftData;             // 2 * fftSize floats, as juce::dsp::FFT expects
+    int fftSize = 0;
+    int maxWindowSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FFTAutocorrelator)
+};
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    McLeodPitchDetector.cpp
+
+  ==============================================================================
+*/
+
+#include "McLeodPitchDetector.h"
+
+void McLeodPitchDetector::prepare(double newSampleRate, int newWindowSize, float minFrequency, float maxFrequency)
+{
+    sampleRate = newSampleRate;
+    windowSize = newWindowSize;
+    prepareLags(sampleRate, windowSize, minFrequency, maxFrequency);
+
+    autocorrelator.prepare(windowSize);
+    autocorr.assign(static_cast<size_t>(windowSize), 0.0f);
+    energy.assign(static_cast<size_t>(windowSize + 1), 0.0f);
+    nsdf.assign(static_cast<size_t>(lags.getEnd() + 1), 0.0f);
+}
+
+PitchEstimate McLeodPitchDetector::detect(const float* window) noexcept
+{
+    autocorrelator.process(window, windowSize, autocorr.data());
+
+    energy[0] = 0.0f;
+    for (int i = 0; i < windowSize; ++i)
+        energy[(size_t)i + 1] = energy[(size_t)i] + window[i] * window[i];
+
+    if (energy[(size_t)windowSize] <= 0.0f)
+        return {};
+
+    // n(tau) = 2 r(tau) / m(tau), where m(tau) is the energy of both overlapping segments
+    const int maxLag = lags.getEnd();
+    const float total = energy[(size_t)windowSize];
+    for (int tau = 0; tau <= maxLag; ++tau)
+    {
+        const float m = energy[(size_t)(windowSize - tau)] + total - energy[(size_t)tau];
+        nsdf[(size_t)tau] = m > 0.0f ? 2.0f * autocorr[(size_t)tau] / m : 0.0f;
+    }
+
+    // Key maxima: the highest point between each positive-going zero crossing and the
+    // next negative-going one.  Two passes keep this allocation-free.
+    auto forEachKeyMaximum = [this, maxLag] (auto&& callback)
+    {
+        int tau = 1;
+        while (tau < maxLag && nsdf[(size_t)tau] > 0.0f)    // Skip the lobe around lag 0
+            ++tau;
+
+        while (tau < maxLag)
+        {
+            while (tau < maxLag && nsdf[(size_t)tau] <= 0.0f)
+                ++tau;
+
+            int peak = tau;
+            for (; tau < maxLag && nsdf[(size_t)tau] > 0.0f; ++tau)
+                if (nsdf[(size_t)tau] > nsdf[(size_t)peak])
+                    peak = tau;
+
+            if (tau < maxLag && peak >= lags.getStart() && callback(peak))
+                return;
+        }
+    };
+
+    float highest = 0.0f;
+    forEachKeyMaximum([this, &highest] (int peak) { highest = juce::jmax(highest, nsdf[(size_t)peak]); return false; });
+
+    if (highest <= 0.0f)
+        return {};
+
+    int bestLag = 0;
+    forEachKeyMaximum([this, &bestLag, highest] (int peak)
+    {
+        if (nsdf[(size_t)peak] < peakRatio * highest)
+            return false;
+
+        bestLag = peak;
+        return true;
+    });
+
+    if (bestLag <= 1 || bestLag >= maxLag)
+        return {};
+
+    const float period = bestLag + parabolicOffset(nsdf[(size_t)bestLag - 1], nsdf[(size_t)bestLag], nsdf[(size_t)bestLag + 1]);
+    return { static_cast<float>(sampleRate / period), juce::jlimit(0.0f, 1.0f, nsdf[(size_t)bestLag]) };
+}
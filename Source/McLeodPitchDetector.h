@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    McLeodPitchDetector.h
+
+    McLeod Pitch Method (McLeod & Wyvill, 2005): normalized square difference
+    function with key-maximum peak picking.  The NSDF peak height doubles as a
+    clarity measure, which is reported as the confidence.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PitchDetector.h"
+#include "FFTAutocorrelator.h"
+
+class McLeodPitchDetector : public PitchDetector
+{
+public:
+    void prepare(double sampleRate, int windowSize, float minFrequency, float maxFrequency) override;
+    PitchEstimate detect(const float* window) noexcept override;
+    const char* getName() const noexcept override { return "McLeod"; }
+
+private:
+    static constexpr float peakRatio = 0.9f;    // Choose the first key maximum within this ratio of the highest
+
+    FFTAutocorrelator autocorrelator;
+    std::vector<float> autocorr;
+    std::vector<float> energy;                  // energy[k] = sum of x[i]^2 for i < k
+    std::vector<float> nsdf;
+    double sampleRate = 44100.0;
+    int windowSize = 0;
+};
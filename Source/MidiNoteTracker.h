@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    MidiNoteTracker.h
+
+    Keeps the notes currently held on the MIDI input, in the order they were
+    pressed, so the most recent one can be the correction target (last-note
+    priority, like a mono synth).  Storage is a fixed table of all 128 notes;
+    nothing allocates, so it is driven straight from the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class MidiNoteTracker
+{
+public:
+    MidiNoteTracker() = default;
+
+    void reset() noexcept { numHeld = 0; }
+
+    void noteOn(int note) noexcept
+    {
+        noteOff(note); // A repeated note moves to the top rather than being held twice
+        held[(size_t)numHeld++] = (uint8_t)note;
+    }
+
+    void noteOff(int note) noexcept
+    {
+        for (int i = 0; i < numHeld; ++i)
+        {
+            if (held[(size_t)i] == note)
+            {
+                std::copy(held.begin() + i + 1, held.begin() + numHeld, held.begin() + i);
+                --numHeld;
+                return;
+            }
+        }
+    }
+
+    // Applies a note on/off or all-notes-off message; returns false for anything else
+    bool handle(const juce::MidiMessage& message) noexcept
+    {
+        if (message.isNoteOn())
+            noteOn(message.getNoteNumber());
+        else if (message.isNoteOff())
+            noteOff(message.getNoteNumber());
+        else if (message.isAllNotesOff() || message.isAllSoundOff())
+            reset();
+        else
+            return false;
+
+        return true;
+    }
+
+    // Most recently pressed note still held, or -1
+    int getTargetNote() const noexcept { return numHeld > 0 ? held[(size_t)numHeld - 1] : -1; }
+
+    // Held notes in the order they were pressed, for harmony voices
+    int getNumHeld() const noexcept { return numHeld; }
+    int getHeldNote(int index) const noexcept { return index < numHeld ? held[(size_t)index] : -1; }
+
+private:
+    std::array<uint8_t, 128> held {};       // Held notes, oldest first
+    int numHeld = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiNoteTracker)
+};
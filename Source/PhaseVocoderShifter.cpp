@@ -0,0 +1,270 @@
+/*
+  ==============================================================================
+
+    PhaseVocoderShifter.cpp
+
+  ==============================================================================
+*/
+
+#include "PhaseVocoderShifter.h"
+
+namespace
+{
+    float wrapPhase(float phase) noexcept
+    {
+        return phase - juce::MathConstants<float>::twoPi
+                         * std::floor((phase + juce::MathConstants<float>::pi) / juce::MathConstants<float>::twoPi);
+    }
+}
+
+void PhaseVocoderShifter::prepare(double sampleRate, int newNumChannels)
+{
+    jassert(newNumChannels <= maxChannels);
+
+    numChannels = juce::jmin(newNumChannels, maxChannels);
+    frameSize = juce::nextPowerOfTwo(juce::roundToInt(sampleRate * 0.04));
+    fftSize = 2 * frameSize;
+    numBins = fftSize / 2 + 1;
+    hopSize = frameSize / 4;
+
+    int order = 0;
+    while ((1 << order) < fftSize)
+        ++order;
+    fft = std::make_unique<juce::dsp::FFT>(order);
+
+    // Periodic Hann for analysis and synthesis; squared, it sums to 1.5 at 75% overlap
+    window.resize(static_cast<size_t>(frameSize));
+    for (int i = 0; i < frameSize; ++i)
+        window[(size_t)i] = 0.5f * (1.0f - std::cos(juce::MathConstants<float>::twoPi * i / frameSize));
+    overlapGain = 1.0f / 1.5f;
+
+    inputHistory.prepare(frameSize, numChannels);
+    outputQueue.setSize(numChannels, frameSize);
+    converted.setSize(numChannels, hopSize);
+    spectra.setSize(numChannels, 2 * fftSize);
+    previousAnalysisPhase.setSize(numChannels, numBins);
+    previousSynthesisPhase.setSize(numChannels, numBins);
+    frameEnergy.assign(static_cast<size_t>(numChannels), 0.0f);
+    midSpectrum.assign(numChannels > 1 ? static_cast<size_t>(2 * numBins) : 0, 0.0f);
+
+    magnitude.assign(static_cast<size_t>(numBins), 0.0f);
+    phase.assign(static_cast<size_t>(numBins), 0.0f);
+    peaks.assign(static_cast<size_t>(numBins), 0);
+    synthesis.assign(static_cast<size_t>(2 * fftSize), 0.0f);
+    envelope.prepare(sampleRate, fftSize);
+
+    reset();
+}
+
+void PhaseVocoderShifter::reset() noexcept
+{
+    inputHistory.clear();
+    outputQueue.clear();
+    spectra.clear();
+    previousAnalysisPhase.clear();
+    previousSynthesisPhase.clear();
+    std::fill(frameEnergy.begin(), frameEnergy.end(), 0.0f);
+    std::fill(midSpectrum.begin(), midSpectrum.end(), 0.0f);
+    midFrameEnergy = 0.0f;
+    samplesSinceFrame = 0;
+}
+
+template <typename SampleType>
+bool PhaseVocoderShifter::process(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples) noexcept
+{
+    jassert(numSamples <= getSamplesUntilNextFrame());
+
+    const int channels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    const float* input[maxChannels] = {};
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            input[channel] = buffer.getReadPointer(channel, startSample);
+        }
+        else
+        {
+            const auto* source = buffer.getReadPointer(channel, startSample);
+            auto* destination = converted.getWritePointer(channel);
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (float)source[i];
+            input[channel] = destination;
+        }
+    }
+    inputHistory.write(input, numSamples, channels);
+
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        const auto* queue = outputQueue.getReadPointer(channel, samplesSinceFrame);
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            buffer.copyFrom(channel, startSample, queue, numSamples);
+        }
+        else
+        {
+            auto* output = buffer.getWritePointer(channel, startSample);
+            for (int i = 0; i < numSamples; ++i)
+                output[i] = (double)queue[i];
+        }
+    }
+
+    samplesSinceFrame += numSamples;
+
+    if (samplesSinceFrame < hopSize)
+        return false;
+
+    samplesSinceFrame = 0;
+    return true;
+}
+
+void PhaseVocoderShifter::analyseFrame() noexcept
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto frame = inputHistory.getSpans(channel, inputHistory.getWritePosition() - frameSize, frameSize);
+        auto* spectrum = spectra.getWritePointer(channel);
+
+        juce::FloatVectorOperations::multiply(spectrum, frame.first, window.data(), frame.firstSize);
+        juce::FloatVectorOperations::multiply(spectrum + frame.firstSize, frame.second, window.data() + frame.firstSize, frame.secondSize);
+        juce::FloatVectorOperations::clear(spectrum + frameSize, 2 * fftSize - frameSize);
+
+        float energy = 0.0f;
+        for (int i = 0; i < frameSize; ++i)
+            energy += spectrum[i] * spectrum[i];
+        frameEnergy[(size_t)channel] = energy;
+
+        fft->performRealOnlyForwardTransform(spectrum, true);
+
+        if (numChannels > 1)
+        {
+            if (channel == 0)
+                juce::FloatVectorOperations::copy(midSpectrum.data(), spectrum, 2 * numBins);
+            else
+                juce::FloatVectorOperations::add(midSpectrum.data(), spectrum, 2 * numBins);
+        }
+    }
+
+    if (numChannels > 1)
+    {
+        // The transform is linear, so the mean of the spectra is the spectrum of the mean
+        // frame, and Parseval gives that frame's energy without going back to the samples
+        juce::FloatVectorOperations::multiply(midSpectrum.data(), 1.0f / (float)numChannels, 2 * numBins);
+
+        float binEnergy = 0.0f;
+        for (int k = 1; k < numBins - 1; ++k)
+            binEnergy += midSpectrum[(size_t)(2 * k)] * midSpectrum[(size_t)(2 * k)] + midSpectrum[(size_t)(2 * k + 1)] * midSpectrum[(size_t)(2 * k + 1)];
+
+        const float dc = midSpectrum[0];
+        const float nyquist = midSpectrum[(size_t)(2 * (numBins - 1))];
+        midFrameEnergy = (dc * dc + nyquist * nyquist + 2.0f * binEnergy) / (float)fftSize;
+    }
+}
+
+void PhaseVocoderShifter::skipFrame() noexcept
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* queue = outputQueue.getWritePointer(channel);
+        std::memmove(queue, queue + hopSize, sizeof(float) * (size_t)(frameSize - hopSize));
+        juce::FloatVectorOperations::clear(queue + frameSize - hopSize, hopSize);
+        frameEnergy[(size_t)channel] = 0.0f;
+    }
+    midFrameEnergy = 0.0f;
+
+    // Phases are meaningless across a gap; the next frame starts propagation afresh
+    previousAnalysisPhase.clear();
+    previousSynthesisPhase.clear();
+}
+
+void PhaseVocoderShifter::synthesiseFrame(float ratio) noexcept
+{
+    const float binToPhaseAdvance = juce::MathConstants<float>::twoPi * hopSize / fftSize;
+    const auto mode = formantMode;
+    const bool preserveFormants = mode != FormantMode::off;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* spectrum = spectra.getReadPointer(channel);
+        auto* lastAnalysisPhase = previousAnalysisPhase.getWritePointer(channel);
+        auto* lastSynthesisPhase = previousSynthesisPhase.getWritePointer(channel);
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            const float re = spectrum[2 * k];
+            const float im = spectrum[2 * k + 1];
+            magnitude[(size_t)k] = std::sqrt(re * re + im * im);
+            phase[(size_t)k] = std::atan2(im, re);
+        }
+
+        // Peaks: local maxima over two bins either side
+        int numPeaks = 0;
+        for (int k = 2; k < numBins - 2; ++k)
+        {
+            const float m = magnitude[(size_t)k];
+            if (m > peakThreshold && m > magnitude[(size_t)k - 1] && m >= magnitude[(size_t)k + 1]
+                && m > magnitude[(size_t)k - 2] && m >= magnitude[(size_t)k + 2])
+                peaks[(size_t)numPeaks++] = k;
+        }
+
+        // Once per frame, from the magnitudes already computed for peak picking
+        if (preserveFormants)
+            envelope.estimate(magnitude.data(), mode);
+        const float* env = envelope.getEnvelope();
+
+        std::fill(synthesis.begin(), synthesis.end(), 0.0f);
+
+        for (int p = 0; p < numPeaks; ++p)
+        {
+            const int peak = peaks[(size_t)p];
+            const int regionStart = p == 0 ? 0 : (peaks[(size_t)p - 1] + peak + 1) / 2;
+            const int regionEnd = p == numPeaks - 1 ? numBins : (peak + peaks[(size_t)p + 1] + 1) / 2;
+
+            // Instantaneous frequency of the peak, as phase advance per hop
+            const float expected = binToPhaseAdvance * peak;
+            const float advance = expected + wrapPhase(phase[(size_t)peak] - lastAnalysisPhase[peak] - expected);
+
+            const int targetPeak = juce::roundToInt(peak * ratio);
+            if (targetPeak <= 0 || targetPeak >= numBins)
+                continue;
+
+            // Identity phase locking: the whole region takes the peak's rotation
+            const float targetPhase = lastSynthesisPhase[targetPeak] + advance * ratio;
+            const float rotation = targetPhase - phase[(size_t)peak];
+            const float cosRotation = std::cos(rotation);
+            const float sinRotation = std::sin(rotation);
+            const int shift = targetPeak - peak;
+
+            for (int k = juce::jmax(regionStart, -shift); k < juce::jmin(regionEnd, numBins - shift); ++k)
+            {
+                // Formant correction: the source bin's envelope swapped for the destination's
+                const float gain = preserveFormants
+                                       ? juce::jlimit(1.0f / maxFormantGain, maxFormantGain, env[k + shift] / env[k])
+                                       : 1.0f;
+                const float re = spectrum[2 * k] * gain;
+                const float im = spectrum[2 * k + 1] * gain;
+                synthesis[(size_t)(2 * (k + shift))] += re * cosRotation - im * sinRotation;
+                synthesis[(size_t)(2 * (k + shift) + 1)] += re * sinRotation + im * cosRotation;
+            }
+        }
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            lastAnalysisPhase[k] = phase[(size_t)k];
+            lastSynthesisPhase[k] = std::atan2(synthesis[(size_t)(2 * k + 1)], synthesis[(size_t)(2 * k)]);
+        }
+
+        fft->performRealOnlyInverseTransform(synthesis.data());
+
+        // Advance the queue by one hop and overlap-add the new frame
+        auto* queue = outputQueue.getWritePointer(channel);
+        std::memmove(queue, queue + hopSize, sizeof(float) * (size_t)(frameSize - hopSize));
+        juce::FloatVectorOperations::clear(queue + frameSize - hopSize, hopSize);
+
+        for (int i = 0; i < frameSize; ++i)
+            queue[i] += synthesis[(size_t)i] * window[(size_t)i] * overlapGain;
+    }
+}
+
+template bool PhaseVocoderShifter::process(juce::AudioBuffer<float>&, int, int) noexcept;
+template bool PhaseVocoderShifter::process(juce::AudioBuffer<double>&, int, int) noexcept;
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    PhaseVocoderShifter.h
+
+    Frequency-domain pitch shifter for polyphonic or noisy material.  Frames
+    of frameSize samples are Hann-windowed, zero-padded to twice their length
+    and transformed every frameSize / 4 samples.  Spectral peaks are moved by
+    the pitch ratio with identity phase locking (Laroche & Dolson, 1999): each
+    peak's region of influence is shifted with it and rotated by the peak's
+    phase correction, so partials keep their shape and phase coherence.
+    With formant preservation on, each moved bin is also rescaled by the
+    ratio of the frame's spectral envelope at its destination and source,
+    so the vowel stays put while the pitch moves.
+
+    Frames are processed in two steps so the processor can run pitch
+    detection on the analysis spectrum before synthesis, instead of
+    transforming the same audio a second time.  Latency is frameSize samples.
+    juce::dsp::FFT is single precision, so double buffers are converted as
+    they enter the input history and leave the output queue.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RingBuffer.h"
+#include "SpectralEnvelope.h"
+
+class PhaseVocoderShifter
+{
+public:
+    static constexpr int maxChannels = 8;   // Up to 7.1
+
+    PhaseVocoderShifter() = default;
+
+    // Picks a power-of-two frame of roughly 40 ms and allocates everything for numChannels.
+    void prepare(double sampleRate, int numChannels);
+    void reset() noexcept;
+
+    int getFrameSize() const noexcept { return frameSize; }
+    int getFFTSize() const noexcept { return fftSize; }
+    int getLatencySamples() const noexcept { return frameSize; }
+
+    // Real-time safe; takes effect from the next synthesised frame.
+    void setFormantMode(FormantMode newMode) noexcept { formantMode = newMode; }
+
+    // Native samples until the next frame is due.
+    int getSamplesUntilNextFrame() const noexcept { return hopSize - samplesSinceFrame; }
+
+    // Queues at most getSamplesUntilNextFrame() input samples and replaces them with
+    // delayed output.  Returns true when a frame is due: call analyseFrame(), then
+    // synthesiseFrame(), before processing more samples.
+    template <typename SampleType>
+    bool process(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples) noexcept;
+
+    // Transforms the newest frame of every channel.
+    void analyseFrame() noexcept;
+
+    // Valid between analyseFrame() and synthesiseFrame(): the interleaved forward
+    // transform of a channel's windowed, zero-padded frame, and that frame's energy.
+    const float* getSpectrum(int channel) const noexcept { return spectra.getReadPointer(channel); }
+    float getFrameEnergy(int channel) const noexcept { return frameEnergy[(size_t)channel]; }
+
+    // The same for the mean of all channels, for detection; channel 0's when mono.
+    const float* getMidSpectrum() const noexcept { return numChannels > 1 ? midSpectrum.data() : spectra.getReadPointer(0); }
+    float getMidFrameEnergy() const noexcept { return numChannels > 1 ? midFrameEnergy : frameEnergy[0]; }
+
+    // Shifts the analysed frame by ratio and overlap-adds it into the output queue.
+    void synthesiseFrame(float ratio) noexcept;
+
+    // Instead of analyseFrame() and synthesiseFrame() when the frame is silent: advances
+    // the output queue without transforming anything, so silence costs no FFTs.
+    void skipFrame() noexcept;
+
+private:
+    static constexpr float peakThreshold = 1.0e-6f;
+    static constexpr float maxFormantGain = 16.0f;  // +-24 dB
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> window;
+    float overlapGain = 1.0f;
+
+    int numChannels = 0;
+    int frameSize = 0;
+    int fftSize = 0;
+    int numBins = 0;
+    int hopSize = 0;
+    int samplesSinceFrame = 0;
+
+    RingBuffer<float, maxChannels> inputHistory;
+    juce::AudioBuffer<float> outputQueue;   // frameSize per channel; [0, hopSize) is due next
+    juce::AudioBuffer<float> converted;     // hopSize per channel, double input on its way in
+    juce::AudioBuffer<float> spectra;       // 2 * fftSize per channel
+    juce::AudioBuffer<float> previousAnalysisPhase;
+    juce::AudioBuffer<float> previousSynthesisPhase;
+    std::vector<float> frameEnergy;
+    std::vector<float> midSpectrum;         // 2 * (fftSize / 2 + 1), multichannel only
+    float midFrameEnergy = 0.0f;
+
+    std::vector<float> magnitude;
+    std::vector<float> phase;
+    std::vector<int> peaks;
+    std::vector<float> synthesis;           // 2 * fftSize
+
+    SpectralEnvelope envelope;
+    FormantMode formantMode = FormantMode::off;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PhaseVocoderShifter)
+};
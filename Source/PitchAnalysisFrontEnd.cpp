@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    PitchAnalysisFrontEnd.cpp
+
+  ==============================================================================
+*/
+
+#include "PitchAnalysisFrontEnd.h"
+
+void PitchAnalysisFrontEnd::prepare(double nativeSampleRate, double windowSeconds, double hopSeconds)
+{
+    decimationFactor = juce::jmax(1, static_cast<int>(std::ceil(nativeSampleRate / maxAnalysisRate)));
+    analysisSampleRate = nativeSampleRate / decimationFactor;
+
+    const int windowSize = juce::jmax(64, juce::roundToInt(windowSeconds * analysisSampleRate));
+    const int hopSize = juce::jlimit(1, windowSize, juce::roundToInt(hopSeconds * analysisSampleRate));
+    scheduler.prepare(windowSize, hopSize);
+    decimated.assign(static_cast<size_t>(hopSize), 0.0f);
+
+    // Blackman-windowed sinc low-pass at 70% of the analysis Nyquist.  Only every
+    // decimationFactor-th output is computed, so the per-sample cost stays ~tapsPerPhase
+    // multiply-adds whatever the native rate is.
+    const int numTaps = decimationFactor > 1 ? tapsPerPhase * decimationFactor + 1 : 1;
+    const double cutoff = 0.35 / decimationFactor;
+    const double centre = 0.5 * (numTaps - 1);
+    taps.resize(static_cast<size_t>(numTaps));
+
+    double sum = 0.0;
+    for (int i = 0; i < numTaps; ++i)
+    {
+        const double x = i - centre;
+        const double sinc = x == 0.0 ? 2.0 * cutoff
+                                     : std::sin(2.0 * juce::MathConstants<double>::pi * cutoff * x) / (juce::MathConstants<double>::pi * x);
+        const double w = numTaps > 1 ? 0.42 - 0.5 * std::cos(2.0 * juce::MathConstants<double>::pi * i / (numTaps - 1))
+                                         + 0.08 * std::cos(4.0 * juce::MathConstants<double>::pi * i / (numTaps - 1))
+                                     : 1.0;
+        taps[(size_t)i] = static_cast<float>(sinc * w);
+        sum += sinc * w;
+    }
+
+    for (auto& tap : taps)
+        tap = static_cast<float>(tap / sum);
+
+    // One hop of new input plus the FIR's reach into the past
+    history.prepare(numTaps + hopSize * decimationFactor);
+    reset();
+}
+
+void PitchAnalysisFrontEnd::reset() noexcept
+{
+    scheduler.reset();
+    history.clear();
+    phase = 0;
+}
+
+int PitchAnalysisFrontEnd::getSamplesUntilNextHop() const noexcept
+{
+    return (scheduler.getSamplesUntilNextHop() - 1) * decimationFactor + (decimationFactor - phase);
+}
+
+bool PitchAnalysisFrontEnd::push(const float* samples, int numSamples) noexcept
+{
+    jassert(numSamples <= getSamplesUntilNextHop());
+
+    const int numTaps = static_cast<int>(taps.size());
+    const auto firstPosition = history.getWritePosition();
+    history.write(&samples, numSamples);
+
+    int numDecimated = 0;
+
+    // Outputs fall on every decimationFactor-th input; each one is the FIR over the
+    // numTaps inputs ending there, read as at most two spans of the ring
+    for (int i = decimationFactor - 1 - phase; i < numSamples; i += decimationFactor)
+    {
+        const auto spans = history.getSpans(0, firstPosition + i + 1 - numTaps, numTaps);
+        const float* tap = taps.data();
+        float acc = 0.0f;
+
+        for (int t = 0; t < spans.firstSize; ++t)
+            acc += spans.first[t] * *tap++;
+        for (int t = 0; t < spans.secondSize; ++t)
+            acc += spans.second[t] * *tap++;
+
+        decimated[(size_t)numDecimated++] = acc;
+    }
+
+    phase = (phase + numSamples) % decimationFactor;
+    return numDecimated > 0 && scheduler.push(decimated.data(), numDecimated);
+}
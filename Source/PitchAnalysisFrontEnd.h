@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    PitchAnalysisFrontEnd.h
+
+    Conditions the detection signal before it reaches the AnalysisScheduler:
+    an anti-aliasing FIR and integer decimation bring any host rate down to
+    roughly 11-16 kHz, so detection costs the same at 192 kHz as at 44.1 kHz.
+    Window and hop are specified in seconds and converted at the analysis
+    rate.  Frequencies found at the analysis rate need no conversion; a period
+    of P analysis samples is P * getDecimationFactor() native samples.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalysisScheduler.h"
+#include "RingBuffer.h"
+
+class PitchAnalysisFrontEnd
+{
+public:
+    PitchAnalysisFrontEnd() = default;
+
+    void prepare(double nativeSampleRate, double windowSeconds, double hopSeconds);
+    void reset() noexcept;
+
+    // Native samples that can be pushed before the next analysis hop completes.
+    int getSamplesUntilNextHop() const noexcept;
+
+    // Filters and decimates at most getSamplesUntilNextHop() native samples.
+    // Returns true when a hop completed and getWindow() holds a fresh window.
+    bool push(const float* samples, int numSamples) noexcept;
+
+    const float* getWindow() const noexcept { return scheduler.getWindow(); }
+    int getWindowSize() const noexcept { return scheduler.getWindowSize(); }
+    int getHopSize() const noexcept { return scheduler.getHopSize(); }
+
+    double getAnalysisSampleRate() const noexcept { return analysisSampleRate; }
+    int getDecimationFactor() const noexcept { return decimationFactor; }
+    int getNativeHopSize() const noexcept { return scheduler.getHopSize() * decimationFactor; }
+    int getNativeWindowSize() const noexcept { return scheduler.getWindowSize() * decimationFactor; }
+
+private:
+    static constexpr double maxAnalysisRate = 16000.0;
+    static constexpr int tapsPerPhase = 16;        // FIR length is tapsPerPhase * factor + 1
+
+    AnalysisScheduler scheduler;
+    std::vector<float> taps;
+    RingBuffer<float, 1> history;                   // Native-rate input for the FIR
+    std::vector<float> decimated;                   // Scratch for one hop of analysis-rate samples
+    double analysisSampleRate = 0.0;
+    int decimationFactor = 1;
+    int phase = 0;                                  // Native samples since the last kept output
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PitchAnalysisFrontEnd)
+};
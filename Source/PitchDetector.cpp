@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+    PitchDetector.cpp
+
+  ==============================================================================
+*/
+
+#include "PitchDetector.h"
+#include "AutocorrelationPitchDetector.h"
+#include "YinPitchDetector.h"
+#include "McLeodPitchDetector.h"
+
+std::unique_ptr<PitchDetector> PitchDetector::create(PitchDetectorType type)
+{
+    switch (type)
+    {
+        case PitchDetectorType::yin:             return std::make_unique<YinPitchDetector>();
+        case PitchDetectorType::mcleod:          return std::make_unique<McLeodPitchDetector>();
+        case PitchDetectorType::autocorrelation:
+        case PitchDetectorType::numTypes:
+        default:                                 return std::make_unique<AutocorrelationPitchDetector>();
+    }
+}
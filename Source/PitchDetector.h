@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    PitchDetector.h
+
+    Common interface for the monophonic pitch detection engines.  Engines are
+    prepared once with the analysis format and must not allocate in detect().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct PitchEstimate
+{
+    float frequency = 0.0f;     // Hz, 0 when no pitch was found
+    float confidence = 0.0f;    // 0..1, engine-specific measure of periodicity
+};
+
+enum class PitchDetectorType
+{
+    autocorrelation = 0,
+    yin,
+    mcleod,
+    numTypes
+};
+
+class PitchDetector
+{
+public:
+    virtual ~PitchDetector() = default;
+
+    // Allocates all working memory for windows of windowSize samples at sampleRate.
+    virtual void prepare(double sampleRate, int windowSize, float minFrequency, float maxFrequency) = 0;
+
+    // Estimates the pitch of exactly windowSize samples.  Real-time safe.
+    virtual PitchEstimate detect(const float* window) noexcept = 0;
+
+    virtual const char* getName() const noexcept = 0;
+
+    static std::unique_ptr<PitchDetector> create(PitchDetectorType type);
+
+    // Narrows the search to [minFrequency, maxFrequency] within the range given to prepare().
+    // Real-time safe.
+    void setFrequencyRange(float minFrequency, float maxFrequency) noexcept
+    {
+        const auto narrowed = lagRange(preparedSampleRate, preparedWindowSize, minFrequency, maxFrequency).getIntersectionWith(preparedLags);
+        lags = narrowed.getLength() >= 2 ? narrowed : preparedLags;
+    }
+
+protected:
+    // Sets the lag search range for prepare(); detect() searches lags
+    void prepareLags(double sampleRate, int windowSize, float minFrequency, float maxFrequency) noexcept
+    {
+        preparedSampleRate = sampleRate;
+        preparedWindowSize = windowSize;
+        preparedLags = lags = lagRange(sampleRate, windowSize, minFrequency, maxFrequency);
+    }
+
+    juce::Range<int> lags;                  // Current search range, never wider than preparedLags
+
+    // Offset in [-0.5, 0.5] of the vertex of the parabola through three equally spaced points
+    static float parabolicOffset(float left, float centre, float right) noexcept
+    {
+        const float denominator = left - 2.0f * centre + right;
+        if (std::abs(denominator) < 1.0e-12f)
+            return 0.0f;
+
+        return juce::jlimit(-0.5f, 0.5f, 0.5f * (left - right) / denominator);
+    }
+
+    // Lag search range in samples, clamped so every lag keeps at least half the window overlapping
+    static juce::Range<int> lagRange(double sampleRate, int windowSize, float minFrequency, float maxFrequency) noexcept
+    {
+        const int maxLag = juce::jlimit(2, windowSize / 2, static_cast<int>(std::ceil(sampleRate / minFrequency)));
+        const int minLag = juce::jlimit(1, maxLag - 1, static_cast<int>(std::floor(sampleRate / maxFrequency)));
+        return { minLag, maxLag };
+    }
+
+private:
+    juce::Range<int> preparedLags;
+    double preparedSampleRate = 44100.0;
+    int preparedWindowSize = 0;
+};
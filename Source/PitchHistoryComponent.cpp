@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    PitchHistoryComponent.cpp
+
+  ==============================================================================
+*/
+
+#include "PitchHistoryComponent.h"
+
+PitchHistoryComponent::PitchHistoryComponent()
+{
+    setOpaque(true);
+}
+
+void PitchHistoryComponent::resized()
+{
+    history = juce::Image(juce::Image::RGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), true);
+    writeColumn = 0;
+    firstNewColumn = 0;
+    numNewColumns = 0;
+    lastDetectedY = -1.0f;
+    lastTargetY = -1.0f;
+}
+
+float PitchHistoryComponent::noteToY(float midiNote) const
+{
+    const float proportion = (midiNote - lowestNote) / (highestNote - lowestNote);
+    return (1.0f - juce::jlimit(0.0f, 1.0f, proportion)) * (float)(history.getHeight() - 1);
+}
+
+void PitchHistoryComponent::addRecord(const PitchTelemetryRecord& record)
+{
+    latest = record;
+
+    if (!history.isValid())
+        return;
+
+    const int width = history.getWidth();
+    const int height = history.getHeight();
+    const float x = (float)writeColumn;
+
+    if (numNewColumns == 0)
+        firstNewColumn = writeColumn;
+    numNewColumns = juce::jmin(width, numNewColumns + 1);
+
+    juce::Graphics g(history);
+    g.setColour(juce::Colours::black);
+    g.fillRect(writeColumn, 0, 1, height);
+
+    // The gap ahead of the sweep; the columns it clears are redrawn as the sweep reaches them
+    for (int i = 1; i <= gapColumns; ++i)
+        g.fillRect((writeColumn + i) % width, 0, 1, height);
+
+    // Octave gridlines at every C
+    g.setColour(juce::Colours::darkgrey);
+    for (float note = lowestNote; note <= highestNote; note += 12.0f)
+        g.fillRect(writeColumn, (int)noteToY(note), 1, 1);
+
+    // Joining to the previous column is skipped at the wrap, where it would cross the image
+    auto drawSegment = [&](float& lastY, float y, float thickness)
+    {
+        if (writeColumn > 0 && lastY >= 0.0f)
+            g.drawLine(x - 1.0f, lastY, x, y, thickness);
+        else
+            g.fillRect(x, y - thickness * 0.5f, 1.0f, thickness);
+
+        lastY = y;
+    };
+
+    if (record.targetNote > 0.0f)
+    {
+        g.setColour(juce::Colours::orange);
+        drawSegment(lastTargetY, noteToY(record.targetNote), 1.0f);
+    }
+    else
+    {
+        lastTargetY = -1.0f;
+    }
+
+    if (record.detectedFrequency > 0.0f)
+    {
+        const float note = 12.0f * std::log2(record.detectedFrequency / 440.0f) + 69.0f;
+        g.setColour(juce::Colours::cyan.withAlpha(0.4f + 0.6f * juce::jlimit(0.0f, 1.0f, record.confidence)));
+        drawSegment(lastDetectedY, noteToY(note), 1.5f);
+    }
+    else
+    {
+        lastDetectedY = -1.0f;
+    }
+
+    writeColumn = (writeColumn + 1) % width;
+}
+
+void PitchHistoryComponent::repaintNewColumns()
+{
+    if (numNewColumns == 0 || !history.isValid())
+        return;
+
+    // The new columns, the one before (their lines join onto it) and the gap after them,
+    // split where they wrap
+    const int width = history.getWidth();
+    const int start = (firstNewColumn + width - 1) % width;
+    const int span = juce::jmin(width, numNewColumns + gapColumns + 1);
+    const int firstPart = juce::jmin(span, width - start);
+    repaint(start, 0, firstPart, getHeight());
+    if (span > firstPart)
+        repaint(0, 0, span - firstPart, getHeight());
+
+    repaint(getReadoutArea());
+    numNewColumns = 0;
+}
+
+void PitchHistoryComponent::paint(juce::Graphics& g)
+{
+    // Clipped to the invalidated area, so a frame only blits the new columns
+    if (history.isValid())
+        g.drawImageAt(history, 0, 0);
+    else
+        g.fillAll(juce::Colours::black);
+
+    g.setColour(juce::Colours::white);
+    g.setFont(14.0f);
+    g.drawText(latest.detectedFrequency > 0.0f ? juce::String(latest.detectedFrequency, 1) + " Hz" : juce::String("--"),
+               getReadoutArea(), juce::Justification::left);
+}
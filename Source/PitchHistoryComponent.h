@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    PitchHistoryComponent.h
+
+    Sweeping graph of detected pitch and correction target, one pixel column
+    per analysis hop.  New columns are rendered once into a cached image used
+    as a circular buffer and shown where they were written, overwriting the
+    oldest, with a short gap marking the sweep.  Nothing already on screen
+    moves, so only the new columns are repainted and the cost of a frame
+    doesn't grow with the amount of history shown.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PitchTelemetry.h"
+
+class PitchHistoryComponent : public juce::Component
+{
+public:
+    PitchHistoryComponent();
+
+    // Message thread.  Renders the record as the newest column; call repaintNewColumns()
+    // after a batch.
+    void addRecord(const PitchTelemetryRecord& record);
+
+    // Invalidates only the columns added since the last call, and the readout.
+    void repaintNewColumns();
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    static constexpr float lowestNote = 36.0f;     // C2
+    static constexpr float highestNote = 84.0f;    // C6
+    static constexpr int gapColumns = 4;            // Cleared ahead of the newest column
+
+    float noteToY(float midiNote) const;
+    juce::Rectangle<int> getReadoutArea() const { return { 4, 2, 120, 18 }; }
+
+    juce::Image history;
+    int writeColumn = 0;
+    int firstNewColumn = 0;                 // Columns written since the last repaintNewColumns()
+    int numNewColumns = 0;
+    float lastDetectedY = -1.0f;
+    float lastTargetY = -1.0f;
+    PitchTelemetryRecord latest;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PitchHistoryComponent)
+};
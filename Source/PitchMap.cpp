@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    PitchMap.cpp
+
+  ==============================================================================
+*/
+
+#include "PitchMap.h"
+#include "PitchAnalysisFrontEnd.h"
+#include "VoicingGate.h"
+
+namespace
+{
+    double readDouble(const char* data) noexcept
+    {
+        double value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    float readFloat(const char* data) noexcept
+    {
+        float value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    PitchMap::AnalysisSettings readSettings(const char* data) noexcept
+    {
+        PitchMap::AnalysisSettings settings;
+        settings.windowSeconds = readDouble(data + 32);
+        settings.hopSeconds = readDouble(data + 40);
+        settings.detector = (PitchDetectorType)juce::ByteOrder::littleEndianInt(data + 48);
+        settings.minFrequency = readFloat(data + 52);
+        settings.maxFrequency = readFloat(data + 56);
+        return settings;
+    }
+}
+
+PitchMap::PitchMap(std::unique_ptr<juce::MemoryMappedFile> mappedFile)
+    : file(std::move(mappedFile))
+{
+    const auto* data = static_cast<const char*>(file->getData());
+
+    sampleRate = readDouble(data + 8);
+    contentHash = juce::ByteOrder::littleEndianInt64(data + 16);
+    hopSize = (int)juce::ByteOrder::littleEndianInt(data + 24);
+    numFrames = (int)juce::ByteOrder::littleEndianInt(data + 28);
+    settings = readSettings(data);
+    frames = reinterpret_cast<const Frame*>(data + headerSize);
+}
+
+std::unique_ptr<PitchMap> PitchMap::open(const juce::File& mapFile, const AnalysisSettings& expectedSettings)
+{
+    // Frames are read in place, which needs a little-endian host
+    if (juce::ByteOrder::isBigEndian() || !mapFile.existsAsFile())
+        return {};
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(mapFile, juce::MemoryMappedFile::readOnly);
+    const auto* data = static_cast<const char*>(mapped->getData());
+    const auto size = mapped->getSize();
+
+    if (data == nullptr || size < (size_t)headerSize || std::memcmp(data, "APMP", 4) != 0
+        || (int)juce::ByteOrder::littleEndianInt(data + 4) != version)
+        return {};
+
+    const auto hop = (int)juce::ByteOrder::littleEndianInt(data + 24);
+    const auto count = (int)juce::ByteOrder::littleEndianInt(data + 28);
+    if (hop <= 0 || count < 0 || size < (size_t)headerSize + (size_t)count * sizeof(Frame))
+        return {};
+
+    // A contour from another detector, window or range would silently differ from what
+    // the processor detects
+    if (readSettings(data) != expectedSettings)
+        return {};
+
+    return std::unique_ptr<PitchMap>(new PitchMap(std::move(mapped)));
+}
+
+bool PitchMap::analyse(juce::AudioFormatReader& reader, const AnalysisSettings& settings, juce::uint64 contentHash,
+                       const juce::File& destination)
+{
+    // The same pipeline as the processor's: decimating front end, detector, voicing gate
+    PitchAnalysisFrontEnd frontEnd;
+    frontEnd.prepare(reader.sampleRate, settings.windowSeconds, settings.hopSeconds);
+    auto detector = PitchDetector::create(settings.detector);
+    detector->prepare(frontEnd.getAnalysisSampleRate(), frontEnd.getWindowSize(), settings.minFrequency, settings.maxFrequency);
+    VoicingGate gate;
+    gate.prepare(frontEnd.getAnalysisSampleRate(), 0);
+
+    constexpr int chunkSize = 8192;
+    const int numChannels = juce::jmax(1, (int)reader.numChannels);
+    juce::AudioBuffer<float> chunk(numChannels, chunkSize);
+    std::vector<float> mid((size_t)chunkSize);
+    std::vector<Frame> contour;
+    contour.reserve((size_t)(reader.lengthInSamples / frontEnd.getNativeHopSize() + 1));
+
+    for (juce::int64 position = 0; position < reader.lengthInSamples; position += chunkSize)
+    {
+        const int numSamples = (int)juce::jmin((juce::int64)chunkSize, reader.lengthInSamples - position);
+        if (!reader.read(&chunk, 0, numSamples, position, true, true))
+            return false;
+
+        // The mean of the channels, like the processor's detection input
+        float* samples = mid.data();
+        juce::FloatVectorOperations::copy(samples, chunk.getReadPointer(0), numSamples);
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::add(samples, chunk.getReadPointer(channel), numSamples);
+        if (numChannels > 1)
+            juce::FloatVectorOperations::multiply(samples, 1.0f / (float)numChannels, numSamples);
+
+        for (int offset = 0; offset < numSamples;)
+        {
+            const int segmentLength = juce::jmin(numSamples - offset, frontEnd.getSamplesUntilNextHop());
+            if (frontEnd.push(samples + offset, segmentLength))
+            {
+                const bool audible = gate.measure(frontEnd.getWindow(), frontEnd.getWindowSize());
+                const auto detected = audible ? detector->detect(frontEnd.getWindow()) : PitchEstimate {};
+                const auto voiced = gate.update(detected);
+                contour.push_back({ voiced.frequency, voiced.confidence });
+            }
+
+            offset += segmentLength;
+        }
+    }
+
+    juce::TemporaryFile temporary(destination);
+    {
+        juce::FileOutputStream stream(temporary.getFile());
+        if (stream.failedToOpen())
+            return false;
+
+        stream.write("APMP", 4);
+        stream.writeInt(version);
+        stream.writeDouble(reader.sampleRate);
+        stream.writeInt64((juce::int64)contentHash);
+        stream.writeInt(frontEnd.getNativeHopSize());
+        stream.writeInt((int)contour.size());
+        stream.writeDouble(settings.windowSeconds);
+        stream.writeDouble(settings.hopSeconds);
+        stream.writeInt((int)settings.detector);
+        stream.writeFloat(settings.minFrequency);
+        stream.writeFloat(settings.maxFrequency);
+        stream.writeInt(0);
+
+        for (auto& frame : contour)
+        {
+            stream.writeFloat(frame.frequency);
+            stream.writeFloat(frame.confidence);
+        }
+
+        stream.flush();
+        if (stream.getStatus().failed())
+            return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
+
+juce::Optional<juce::uint64> PitchMap::hashAudio(juce::AudioFormatReader& reader)
+{
+    constexpr juce::uint64 prime = 0x100000001b3ULL;
+    juce::uint64 hash = 0xcbf29ce484222325ULL;
+
+    auto addBytes = [&hash] (const void* bytes, size_t size)
+    {
+        const auto* b = static_cast<const juce::uint8*>(bytes);
+        for (size_t i = 0; i < size; ++i)
+            hash = (hash ^ b[i]) * prime;
+    };
+
+    const double rate = reader.sampleRate;
+    addBytes(&rate, sizeof(rate));
+
+    constexpr int chunkSize = 8192;
+    const int numChannels = (int)reader.numChannels;
+    juce::AudioBuffer<float> chunk(numChannels, chunkSize);
+
+    for (juce::int64 position = 0; position < reader.lengthInSamples; position += chunkSize)
+    {
+        const int numSamples = (int)juce::jmin((juce::int64)chunkSize, reader.lengthInSamples - position);
+        if (!reader.read(&chunk, 0, numSamples, position, true, true))
+            return {};
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            addBytes(chunk.getReadPointer(channel), sizeof(float) * (size_t)numSamples);
+    }
+
+    return hash;
+}
+
+juce::File PitchMap::getCacheFile(const juce::File& cacheFolder, juce::uint64 hash)
+{
+    return cacheFolder.getChildFile(juce::String::toHexString((juce::int64)hash).paddedLeft('0', 16) + ".pitchmap");
+}
+
+PitchEstimate PitchMap::getEstimate(juce::int64 samplePosition) const noexcept
+{
+    const auto index = samplePosition / hopSize - 1;
+    if (index < 0 || index >= numFrames)
+        return {};
+
+    const auto& frame = frames[index];
+    return { frame.frequency, frame.confidence };
+}
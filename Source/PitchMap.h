@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    PitchMap.h
+
+    Pitch contour of a whole take, analysed offline once and then read back
+    instead of detecting in real time.  Files hold a 64-byte header and one
+    8-byte frame per analysis hop; a frame's time is implicit in its index,
+    so the file is memory-mapped and read in place with no parsing or
+    allocation.  Maps are keyed by a hash of the audio itself, so a cache
+    folder survives renames and moves of the takes, and record the settings
+    they were analysed with, so a map made with others isn't mistaken for
+    a current one.
+
+    Layout, little-endian:
+        char[4] "APMP", int32 version, double sampleRate, uint64 contentHash,
+        int32 hopSize (native samples), int32 numFrames, double windowSeconds,
+        double hopSeconds, int32 detector, float minFrequency,
+        float maxFrequency, int32 reserved (0), then numFrames of
+        { float frequency (Hz, 0 when unvoiced), float confidence }.
+    Frame i describes the hop that ended at native sample (i + 1) * hopSize.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PitchDetector.h"
+
+class PitchMap
+{
+public:
+    struct AnalysisSettings
+    {
+        PitchDetectorType detector = PitchDetectorType::autocorrelation;
+        double windowSeconds = 0.046;
+        double hopSeconds = 0.0058;
+        float minFrequency = 50.0f;
+        float maxFrequency = 1000.0f;
+
+        bool operator==(const AnalysisSettings& other) const noexcept
+        {
+            return detector == other.detector && windowSeconds == other.windowSeconds && hopSeconds == other.hopSeconds
+                   && minFrequency == other.minFrequency && maxFrequency == other.maxFrequency;
+        }
+
+        bool operator!=(const AnalysisSettings& other) const noexcept { return !(*this == other); }
+    };
+
+    // Maps file, or returns nullptr if it is missing, truncated, not a pitch map or was
+    // analysed with settings other than expectedSettings.
+    static std::unique_ptr<PitchMap> open(const juce::File& file, const AnalysisSettings& expectedSettings);
+
+    // Runs the detection pipeline over the mean of the reader's channels, as the processor
+    // detects live, and writes a map of it
+    // to destination, replacing it atomically.  contentHash is the reader's hashAudio(),
+    // which the caller has already needed to find the cache file.  Not real-time safe.
+    static bool analyse(juce::AudioFormatReader& reader, const AnalysisSettings& settings, juce::uint64 contentHash,
+                        const juce::File& destination);
+
+    // 64-bit FNV-1a over the decoded samples and the sample rate; the cache key.  Empty
+    // if the reader fails, so a truncated file can't match a map of the intact one.
+    static juce::Optional<juce::uint64> hashAudio(juce::AudioFormatReader& reader);
+    static juce::File getCacheFile(const juce::File& cacheFolder, juce::uint64 contentHash);
+
+    double getSampleRate() const noexcept { return sampleRate; }
+    int getHopSize() const noexcept { return hopSize; }
+    int getNumFrames() const noexcept { return numFrames; }
+    juce::uint64 getContentHash() const noexcept { return contentHash; }
+    const AnalysisSettings& getSettings() const noexcept { return settings; }
+
+    // The estimate for the hop ending at samplePosition; unvoiced outside the take.
+    // Real-time safe.
+    PitchEstimate getEstimate(juce::int64 samplePosition) const noexcept;
+
+private:
+    static constexpr int headerSize = 64;
+    static constexpr int version = 2;
+
+    struct Frame
+    {
+        float frequency;
+        float confidence;
+    };
+
+    explicit PitchMap(std::unique_ptr<juce::MemoryMappedFile> mappedFile);
+
+    std::unique_ptr<juce::MemoryMappedFile> file;
+    const Frame* frames = nullptr;          // Points into the mapped file
+    double sampleRate = 0.0;
+    juce::uint64 contentHash = 0;
+    int hopSize = 0;
+    int numFrames = 0;
+    AnalysisSettings settings;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PitchMap)
+};
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    PitchTelemetry.h
+
+    Per-hop analysis records passed from the audio thread to the editor
+    through a wait-free single-producer, single-consumer FIFO.  The audio
+    thread never blocks or allocates: when the editor isn't draining, new
+    records are dropped.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct PitchTelemetryRecord
+{
+    juce::int64 samplePosition = 0;     // Input samples since prepareToPlay when the hop was analysed
+    float detectedFrequency = 0.0f;     // Hz, 0 when unvoiced
+    float targetNote = 0.0f;            // MIDI note the correction aims at, 0 when none
+    float ratio = 1.0f;                 // Pitch ratio applied over the following hop
+    float confidence = 0.0f;
+};
+
+class PitchTelemetryFifo
+{
+public:
+    static constexpr int capacity = 1024;
+
+    // Audio thread.  Returns false if the record was dropped because the FIFO is full.
+    bool push(const PitchTelemetryRecord& record) noexcept
+    {
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 > 0)
+            records[(size_t)scope.startIndex1] = record;
+        else if (scope.blockSize2 > 0)
+            records[(size_t)scope.startIndex2] = record;
+        else
+            return false;
+
+        return true;
+    }
+
+    // Message thread.  Calls callback(const PitchTelemetryRecord&) for every pending record, oldest first.
+    template <typename Callback>
+    int drain(Callback&& callback)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+        for (int i = 0; i < scope.blockSize1; ++i)
+            callback(records[(size_t)(scope.startIndex1 + i)]);
+        for (int i = 0; i < scope.blockSize2; ++i)
+            callback(records[(size_t)(scope.startIndex2 + i)]);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<PitchTelemetryRecord, capacity> records {};
+};
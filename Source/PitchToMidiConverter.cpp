@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    PitchToMidiConverter.cpp
+
+  ==============================================================================
+*/
+
+#include "PitchToMidiConverter.h"
+
+void PitchToMidiConverter::reset() noexcept
+{
+    currentNote = -1;
+    currentBend = 8192;
+}
+
+void PitchToMidiConverter::process(float frequency, float confidence, int samplePosition, juce::MidiBuffer& output)
+{
+    const bool voiced = frequency > 0.0f && confidence >= (currentNote < 0 ? noteOnConfidence : noteOffConfidence);
+    if (!voiced)
+    {
+        stop(samplePosition, output);
+        return;
+    }
+
+    const float midiNote = 12.0f * std::log2(frequency / 440.0f) + 69.0f;
+    if (midiNote < 0.0f || midiNote > 127.0f)
+    {
+        stop(samplePosition, output);
+        return;
+    }
+
+    if (currentNote < 0 || std::abs(midiNote - (float)currentNote) > 0.5f + noteChangeMargin)
+    {
+        stop(samplePosition, output);
+
+        // The bend goes first so the new note never sounds at the old note's offset
+        currentNote = juce::jlimit(0, 127, juce::roundToInt(midiNote));
+        sendBend(midiNote - (float)currentNote, samplePosition, output);
+        output.addEvent(juce::MidiMessage::noteOn(channel, currentNote, velocity), samplePosition);
+        return;
+    }
+
+    sendBend(midiNote - (float)currentNote, samplePosition, output);
+}
+
+void PitchToMidiConverter::stop(int samplePosition, juce::MidiBuffer& output)
+{
+    if (currentNote < 0)
+        return;
+
+    output.addEvent(juce::MidiMessage::noteOff(channel, currentNote), samplePosition);
+    currentNote = -1;
+}
+
+void PitchToMidiConverter::sendBend(float semitones, int samplePosition, juce::MidiBuffer& output)
+{
+    const int bend = juce::MidiMessage::pitchbendToPitchwheelPos(juce::jlimit(-bendRangeSemitones, bendRangeSemitones, semitones), bendRangeSemitones);
+    if (bend == currentBend)
+        return;
+
+    output.addEvent(juce::MidiMessage::pitchWheel(channel, bend), samplePosition);
+    currentBend = bend;
+}
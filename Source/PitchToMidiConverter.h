@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    PitchToMidiConverter.h
+
+    Turns the detector's per-hop estimates into a monophonic MIDI stream:
+    note-on/off for the nearest note and pitch bend for the distance from it.
+    A note starts only on a confident estimate and ends only when confidence
+    drops well below that, and the note changes only once the pitch has moved
+    past the midpoint by a margin, so vibrato and scoops bend instead of
+    retriggering.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class PitchToMidiConverter
+{
+public:
+    static constexpr int channel = 1;
+    static constexpr float bendRangeSemitones = 2.0f;  // The General MIDI default, so synths need no setup
+
+    PitchToMidiConverter() = default;
+
+    // Forgets the sounding note without sending a note-off
+    void reset() noexcept;
+
+    // Adds the events for one estimate at samplePosition in output.
+    void process(float frequency, float confidence, int samplePosition, juce::MidiBuffer& output);
+
+    // Ends the sounding note, if any
+    void stop(int samplePosition, juce::MidiBuffer& output);
+
+private:
+    static constexpr float noteOnConfidence = 0.7f;
+    static constexpr float noteOffConfidence = 0.4f;
+    static constexpr float noteChangeMargin = 0.25f;   // Semitones beyond the midpoint between notes
+    static constexpr juce::uint8 velocity = 100;
+
+    void sendBend(float semitones, int samplePosition, juce::MidiBuffer& output);
+
+    int currentNote = -1;                   // Sounding note, or -1
+    int currentBend = 8192;                 // Last pitch wheel value sent
+};
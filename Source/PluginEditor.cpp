@@ -10,18 +10,104 @@
 #include "PluginEditor.h"
 
 AutotuneAudioProcessorEditor::AutotuneAudioProcessorEditor(AutotuneAudioProcessor& p)
-    : AudioProcessorEditor(&p), audioProcessor(p), displayedPitch(0.0f)
+    : AudioProcessorEditor(&p), audioProcessor(p)
 {
-    startTimer(100); // Update every 100ms
+    startTimerHz(30);
 
-    retuneSpeedSlider.setRange(0.0, 1.0, 0.01);
-    retuneSpeedSlider.setValue(0.1);
+    auto& parameters = audioProcessor.getParameters();
+
+    retuneSpeedSlider.setTextValueSuffix(" ms");
+    retuneSpeedAttachment = std::make_unique<SliderAttachment>(parameters, ParameterIDs::retuneSpeed, retuneSpeedSlider);
     addAndMakeVisible(retuneSpeedSlider);
 
-    pitchLabel.setText("Pitch: 0 Hz", juce::dontSendNotification);
-    addAndMakeVisible(pitchLabel);
+    mixAttachment = std::make_unique<SliderAttachment>(parameters, ParameterIDs::mix, mixSlider);
+    addAndMakeVisible(mixSlider);
+
+    minFrequencySlider.setSliderStyle(juce::Slider::LinearBar);
+    minFrequencySlider.setTextValueSuffix(" Hz");
+    minFrequencyAttachment = std::make_unique<SliderAttachment>(parameters, ParameterIDs::minFrequency, minFrequencySlider);
+    addAndMakeVisible(minFrequencySlider);
+
+    maxFrequencySlider.setSliderStyle(juce::Slider::LinearBar);
+    maxFrequencySlider.setTextValueSuffix(" Hz");
+    maxFrequencyAttachment = std::make_unique<SliderAttachment>(parameters, ParameterIDs::maxFrequency, maxFrequencySlider);
+    addAndMakeVisible(maxFrequencySlider);
+
+    // Items must exist before the attachments select one; IDs are the choice index + 1
+    for (int i = 0; i < (int)PitchDetectorType::numTypes; ++i)
+        detectorBox.addItem(audioProcessor.getPitchDetectorName((PitchDetectorType)i), i + 1);
+    detectorAttachment = std::make_unique<ComboBoxAttachment>(parameters, ParameterIDs::detector, detectorBox);
+    addAndMakeVisible(detectorBox);
+
+    modeBox.addItem("PSOLA", (int)ProcessingMode::psola + 1);
+    modeBox.addItem("Phase vocoder", (int)ProcessingMode::phaseVocoder + 1);
+    modeAttachment = std::make_unique<ComboBoxAttachment>(parameters, ParameterIDs::engine, modeBox);
+    addAndMakeVisible(modeBox);
+
+    for (int i = 0; i < 12; ++i)
+        keyBox.addItem(juce::MidiMessage::getMidiNoteName(i, true, false, 4), i + 1);
+    keyAttachment = std::make_unique<ComboBoxAttachment>(parameters, ParameterIDs::key, keyBox);
+    addAndMakeVisible(keyBox);
+
+    for (int i = 0; i < (int)ScaleType::numScales; ++i)
+        scaleBox.addItem(ScaleTables::getScaleName((ScaleType)i), i + 1);
+    scaleAttachment = std::make_unique<ComboBoxAttachment>(parameters, ParameterIDs::scale, scaleBox);
+    addAndMakeVisible(scaleBox);
+
+    targetBox.addItem("Snap to scale", (int)TargetMode::scale + 1);
+    targetBox.addItem("Follow MIDI notes", (int)TargetMode::midiNotes + 1);
+    targetAttachment = std::make_unique<ComboBoxAttachment>(parameters, ParameterIDs::targetMode, targetBox);
+    addAndMakeVisible(targetBox);
+
+    interpolationBox.addItem("Draft", (int)InterpolationQuality::draft + 1);
+    interpolationBox.addItem("Normal", (int)InterpolationQuality::normal + 1);
+    interpolationBox.addItem("High", (int)InterpolationQuality::high + 1);
+    interpolationAttachment = std::make_unique<ComboBoxAttachment>(parameters, ParameterIDs::interpolation, interpolationBox);
+    addAndMakeVisible(interpolationBox);
+
+    formantsBox.addItem("Formants: off", (int)FormantMode::off + 1);
+    formantsBox.addItem("Formants: fast", (int)FormantMode::fast + 1);
+    formantsBox.addItem("Formants: high", (int)FormantMode::high + 1);
+    formantsAttachment = std::make_unique<ComboBoxAttachment>(parameters, ParameterIDs::formants, formantsBox);
+    addAndMakeVisible(formantsBox);
+
+    midiOutputAttachment = std::make_unique<ButtonAttachment>(parameters, ParameterIDs::midiOutput, midiOutputButton);
+    addAndMakeVisible(midiOutputButton);
 
-    setSize(400, 300);
+    lookaheadAttachment = std::make_unique<ButtonAttachment>(parameters, ParameterIDs::lookahead, lookaheadButton);
+    addAndMakeVisible(lookaheadButton);
+
+    backgroundAnalysisAttachment = std::make_unique<ButtonAttachment>(parameters, ParameterIDs::backgroundAnalysis, backgroundAnalysisButton);
+    addAndMakeVisible(backgroundAnalysisButton);
+
+    harmonySourceBox.addItem("Harmony: intervals", (int)HarmonySource::intervals + 1);
+    harmonySourceBox.addItem("Harmony: MIDI notes", (int)HarmonySource::midiNotes + 1);
+    harmonySourceAttachment = std::make_unique<ComboBoxAttachment>(parameters, ParameterIDs::harmonySource, harmonySourceBox);
+    addAndMakeVisible(harmonySourceBox);
+
+    harmonyVoicesSlider.setSliderStyle(juce::Slider::LinearBar);
+    harmonyVoicesSlider.setTextValueSuffix(" voices");
+    harmonyVoicesAttachment = std::make_unique<SliderAttachment>(parameters, ParameterIDs::harmonyVoices, harmonyVoicesSlider);
+    addAndMakeVisible(harmonyVoicesSlider);
+
+    harmonyLevelSlider.setSliderStyle(juce::Slider::LinearBar);
+    harmonyLevelAttachment = std::make_unique<SliderAttachment>(parameters, ParameterIDs::harmonyLevel, harmonyLevelSlider);
+    addAndMakeVisible(harmonyLevelSlider);
+
+    for (size_t i = 0; i < harmonyIntervalSliders.size(); ++i)
+    {
+        harmonyIntervalSliders[i].setSliderStyle(juce::Slider::LinearBar);
+        harmonyIntervalAttachments[i] = std::make_unique<SliderAttachment>(parameters, ParameterIDs::harmonyIntervals[i], harmonyIntervalSliders[i]);
+        addAndMakeVisible(harmonyIntervalSliders[i]);
+    }
+
+    addAndMakeVisible(loadLabel);
+
+    // Anything queued while the editor was closed is stale
+    audioProcessor.getTelemetry().drain([](const PitchTelemetryRecord&) {});
+    addAndMakeVisible(pitchHistory);
+
+    setSize(400, 420);
 }
 
 AutotuneAudioProcessorEditor::~AutotuneAudioProcessorEditor()
@@ -39,12 +125,35 @@ void AutotuneAudioProcessorEditor::paint(juce::Graphics& g)
 
 void AutotuneAudioProcessorEditor::resized()
 {
-    retuneSpeedSlider.setBounds(10, 40, 380, 20);
-    pitchLabel.setBounds(10, 70, 380, 20);
+    retuneSpeedSlider.setBounds(10, 40, 180, 20);
+    targetBox.setBounds(210, 38, 180, 24);
+    keyBox.setBounds(10, 70, 180, 24);
+    scaleBox.setBounds(210, 70, 180, 24);
+    detectorBox.setBounds(10, 100, 180, 24);
+    modeBox.setBounds(210, 100, 180, 24);
+    mixSlider.setBounds(10, 130, 180, 20);
+    minFrequencySlider.setBounds(210, 130, 85, 20);
+    maxFrequencySlider.setBounds(305, 130, 85, 20);
+    loadLabel.setBounds(10, 160, 190, 20);
+    interpolationBox.setBounds(210, 158, 85, 24);
+    midiOutputButton.setBounds(300, 158, 90, 24);
+    lookaheadButton.setBounds(10, 188, 85, 24);
+    formantsBox.setBounds(95, 188, 95, 24);
+    harmonySourceBox.setBounds(210, 188, 180, 24);
+    harmonyVoicesSlider.setBounds(10, 220, 85, 20);
+    harmonyLevelSlider.setBounds(105, 220, 85, 20);
+    for (size_t i = 0; i < harmonyIntervalSliders.size(); ++i)
+        harmonyIntervalSliders[i].setBounds(210 + 46 * (int)i, 220, 42, 20);
+    backgroundAnalysisButton.setBounds(10, 248, 180, 24);
+    pitchHistory.setBounds(10, 280, 380, 130);
 }
 
 void AutotuneAudioProcessorEditor::timerCallback()
 {
-    displayedPitch = audioProcessor.previousPitch; 
-    pitchLabel.setText("Pitch: " + juce::String(displayedPitch, 1) + " Hz", juce::dontSendNotification);
-}
\ No newline at end of file
+    if (audioProcessor.getTelemetry().drain([this](const PitchTelemetryRecord& record) { pitchHistory.addRecord(record); }) > 0)
+        pitchHistory.repaintNewColumns();
+
+    loadLabel.setText("PSOLA " + juce::String(audioProcessor.getProcessingLoad(ProcessingMode::psola), 1)
+                          + "%, phase vocoder " + juce::String(audioProcessor.getProcessingLoad(ProcessingMode::phaseVocoder), 1) + "%",
+                      juce::dontSendNotification);
+}
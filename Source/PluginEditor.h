@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "PitchHistoryComponent.h"
 
 class AutotuneAudioProcessorEditor : public juce::AudioProcessorEditor, public juce::Timer
 {
@@ -22,10 +23,38 @@ public:
     void timerCallback() override;
 
 private:
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
+
     AutotuneAudioProcessor& audioProcessor;
     juce::Slider retuneSpeedSlider;
-    juce::Label pitchLabel;
-    float displayedPitch;
+    juce::Slider mixSlider;
+    juce::Slider minFrequencySlider;
+    juce::Slider maxFrequencySlider;
+    juce::ComboBox detectorBox;
+    juce::ComboBox modeBox;
+    juce::ComboBox keyBox;
+    juce::ComboBox scaleBox;
+    juce::ComboBox targetBox;
+    juce::ComboBox interpolationBox;
+    juce::ComboBox formantsBox;
+    juce::ToggleButton midiOutputButton { "MIDI out" };
+    juce::ToggleButton lookaheadButton { "Lookahead" };
+    juce::ToggleButton backgroundAnalysisButton { "Background analysis (bass)" };
+    juce::Slider harmonyVoicesSlider;
+    juce::Slider harmonyLevelSlider;
+    juce::ComboBox harmonySourceBox;
+    std::array<juce::Slider, PsolaShifter::maxHarmonies> harmonyIntervalSliders;
+    juce::Label loadLabel;
+    PitchHistoryComponent pitchHistory;
+
+    // Declared after the controls so they are destroyed first
+    std::unique_ptr<SliderAttachment> retuneSpeedAttachment, mixAttachment, minFrequencyAttachment, maxFrequencyAttachment;
+    std::unique_ptr<SliderAttachment> harmonyVoicesAttachment, harmonyLevelAttachment;
+    std::array<std::unique_ptr<SliderAttachment>, PsolaShifter::maxHarmonies> harmonyIntervalAttachments;
+    std::unique_ptr<ComboBoxAttachment> detectorAttachment, modeAttachment, keyAttachment, scaleAttachment, targetAttachment, interpolationAttachment, formantsAttachment, harmonySourceAttachment;
+    std::unique_ptr<ButtonAttachment> midiOutputAttachment, lookaheadAttachment, backgroundAnalysisAttachment;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutotuneAudioProcessorEditor)
 };
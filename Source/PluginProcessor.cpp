@@ -14,18 +14,116 @@ AutotuneAudioProcessor::AutotuneAudioProcessor()
     : AudioProcessor(BusesProperties()
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
-    circularBuffer(2, bufferSize * 2)  // Double bufferSize for safety
+      parameters(*this, nullptr, "Autotune", createParameterLayout())
 {
-    std::fill(analysisBuffer, analysisBuffer + bufferSize, 0.0f);
+    retuneSpeedParameter = cacheParameter(ParameterIDs::retuneSpeed);
+    keyParameter = cacheParameter(ParameterIDs::key);
+    scaleParameter = cacheParameter(ParameterIDs::scale);
+    mixParameter = cacheParameter(ParameterIDs::mix);
+    engineParameter = cacheParameter(ParameterIDs::engine);
+    detectorParameter = cacheParameter(ParameterIDs::detector);
+    minFrequencyParameter = cacheParameter(ParameterIDs::minFrequency);
+    maxFrequencyParameter = cacheParameter(ParameterIDs::maxFrequency);
+    targetModeParameter = cacheParameter(ParameterIDs::targetMode);
+    midiOutputParameter = cacheParameter(ParameterIDs::midiOutput);
+    interpolationParameter = cacheParameter(ParameterIDs::interpolation);
+    lookaheadParameter = cacheParameter(ParameterIDs::lookahead);
+    formantsParameter = cacheParameter(ParameterIDs::formants);
+    backgroundAnalysisParameter = cacheParameter(ParameterIDs::backgroundAnalysis);
+    harmonyVoicesParameter = cacheParameter(ParameterIDs::harmonyVoices);
+    harmonySourceParameter = cacheParameter(ParameterIDs::harmonySource);
+    harmonyLevelParameter = cacheParameter(ParameterIDs::harmonyLevel);
+    for (size_t i = 0; i < harmonyIntervalParameters.size(); ++i)
+        harmonyIntervalParameters[i] = cacheParameter(ParameterIDs::harmonyIntervals[i]);
+
+    analysisWindowSeconds = defaultWindowSeconds;
+    analysisHopSeconds = defaultHopSeconds;
+    for (size_t i = 0; i < pitchDetectors.size(); ++i)
+        pitchDetectors[i] = PitchDetector::create((PitchDetectorType)i);
+    activeProcessingMode = (int)ProcessingMode::psola;
     currentSampleRate = 0.0;
-    writePosition = 0;
-    readPosition = 0.0f;
     previousPitch = 0.0f;
-    circularBuffer.clear();
+    inputPosition = 0;
+    customScaleMask = ScaleTables::masks[(int)ScaleType::major];
+    followMidiNotes = false;
+    midiOutputActive = false;
+    hopMilliseconds = 0.0f;
+    lookaheadSamples = 0;
+    lookaheadActive = false;
+    numChannels = 1;
+    workerActive = false;
+    pendingLatencySamples = 0;
+    pendingMidiKey = -1;
+    pendingMidiScale = -1;
+
+   #if JUCE_DEBUG
+    // Debug builds of the plugin log what DBG used to print, without formatting on the audio
+    // thread, each instance to its own file.  Processors the tools create directly have no
+    // wrapper and start the logger themselves if they want it.
+    if (wrapperType != wrapperType_Undefined)
+    {
+        logger.start(juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("Autotune", ".log", false));
+        logger.setCategoryEnabled(RealtimeLogger::pitch, true);
+        logger.setCategoryEnabled(RealtimeLogger::engine, true);
+        logger.setCategoryEnabled(RealtimeLogger::timing, true);
+    }
+   #endif
 }
 
 AutotuneAudioProcessor::~AutotuneAudioProcessor()
 {
+    cancelPendingUpdate();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout AutotuneAudioProcessor::createParameterLayout()
+{
+    juce::StringArray keyNames, scaleNames, detectorNames;
+    for (int i = 0; i < 12; ++i)
+        keyNames.add(juce::MidiMessage::getMidiNoteName(i, true, false, 4));
+    for (int i = 0; i < (int)ScaleType::numScales; ++i)
+        scaleNames.add(ScaleTables::getScaleName((ScaleType)i));
+    for (int i = 0; i < (int)PitchDetectorType::numTypes; ++i)
+        detectorNames.add(PitchDetector::create((PitchDetectorType)i)->getName());
+
+    // Most of the useful travel of both is at the low end
+    juce::NormalisableRange<float> retuneRange(0.0f, 400.0f, 1.0f);
+    retuneRange.setSkewForCentre(50.0f);
+    juce::NormalisableRange<float> frequencyRange(minDetectableFrequency, maxDetectableFrequency, 1.0f);
+    frequencyRange.setSkewForCentre(220.0f);
+
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(ParameterIDs::retuneSpeed, 1), "Retune speed", retuneRange, 50.0f),
+               std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ParameterIDs::key, 1), "Key", keyNames, 0),
+               std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ParameterIDs::scale, 1), "Scale", scaleNames, (int)ScaleType::major),
+               std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(ParameterIDs::mix, 1), "Mix", juce::NormalisableRange<float>(0.0f, 1.0f), 1.0f),
+               std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ParameterIDs::engine, 1), "Engine", juce::StringArray { "PSOLA", "Phase vocoder" }, (int)ProcessingMode::psola),
+               std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ParameterIDs::detector, 1), "Detector", detectorNames, (int)PitchDetectorType::autocorrelation),
+               std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(ParameterIDs::minFrequency, 1), "Lowest pitch", frequencyRange, minDetectableFrequency),
+               std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(ParameterIDs::maxFrequency, 1), "Highest pitch", frequencyRange, maxDetectableFrequency),
+               std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ParameterIDs::targetMode, 1), "Target", juce::StringArray { "Snap to scale", "Follow MIDI notes" }, (int)TargetMode::scale),
+               std::make_unique<juce::AudioParameterBool>(juce::ParameterID(ParameterIDs::midiOutput, 1), "MIDI output", false),
+               std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ParameterIDs::interpolation, 1), "Interpolation", juce::StringArray { "Draft", "Normal", "High" }, (int)InterpolationQuality::normal),
+               std::make_unique<juce::AudioParameterBool>(juce::ParameterID(ParameterIDs::lookahead, 1), "Lookahead", false),
+               std::make_unique<juce::AudioParameterInt>(juce::ParameterID(ParameterIDs::harmonyVoices, 1), "Harmony voices", 0, PsolaShifter::maxHarmonies, 0),
+               std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ParameterIDs::harmonySource, 1), "Harmony source", juce::StringArray { "Intervals", "MIDI notes" }, (int)HarmonySource::intervals),
+               std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(ParameterIDs::harmonyLevel, 1), "Harmony level", juce::NormalisableRange<float>(0.0f, 1.0f), 0.7f),
+               std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(ParameterIDs::formants, 1), "Formants", juce::StringArray { "Off", "Fast", "High" }, (int)FormantMode::off),
+               std::make_unique<juce::AudioParameterBool>(juce::ParameterID(ParameterIDs::backgroundAnalysis, 1), "Background analysis", false));
+
+    // Third, fifth, octave and fourth below; snapped to the scale, so thirds stay diatonic
+    static_assert(std::size(ParameterIDs::harmonyIntervals) == (size_t)PsolaShifter::maxHarmonies);
+    const int defaultIntervals[] = { 4, 7, 12, -5 };
+    for (int i = 0; i < PsolaShifter::maxHarmonies; ++i)
+        layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID(ParameterIDs::harmonyIntervals[i], 1), "Harmony " + juce::String(i + 1) + " interval",
+                                                             -24, 24, defaultIntervals[i]));
+    return layout;
+}
+
+AutotuneAudioProcessor::CachedParameter AutotuneAudioProcessor::cacheParameter(const char* parameterID)
+{
+    CachedParameter cached { parameters.getParameter(parameterID), parameters.getRawParameterValue(parameterID) };
+    jassert(cached.parameter != nullptr && cached.value != nullptr);
+    return cached;
 }
 
 //==============================================================================
@@ -36,12 +134,12 @@ const juce::String AutotuneAudioProcessor::getName() const
 
 bool AutotuneAudioProcessor::acceptsMidi() const
 {
-    return true; // Enable MIDI for potential scale/key input later
+    return true; // Target notes, key and scale selection, see handleMidiMessage
 }
 
 bool AutotuneAudioProcessor::producesMidi() const
 {
-    return false;
+    return true; // Detected pitch as notes and bends, see setMidiOutputEnabled
 }
 
 bool AutotuneAudioProcessor::isMidiEffect() const
@@ -81,125 +179,602 @@ void AutotuneAudioProcessor::changeProgramName(int index, const juce::String& ne
 void AutotuneAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
     currentSampleRate = sampleRate;
-    circularBuffer.setSize(2, samplesPerBlock * 2); // Ensure enough room
-    circularBuffer.clear();
-    writePosition = 0;
-    readPosition = 0.0f;
+    numChannels = juce::jlimit(1, maxChannels, getTotalNumInputChannels());
+    previousPitch = 0.0f;
+    inputPosition = 0;
+    heldNotes.reset();
+    pitchToMidi.reset();
+    midiOutputActive = false;
+    analysisFrontEnd.prepare(sampleRate, analysisWindowSeconds, analysisHopSeconds);
+    for (auto& detector : pitchDetectors)
+        detector->prepare(analysisFrontEnd.getAnalysisSampleRate(), analysisFrontEnd.getWindowSize(), minDetectableFrequency, maxDetectableFrequency);
+    pitchRatio.reset(analysisFrontEnd.getNativeHopSize());
+    pitchRatio.setCurrentAndTargetValue(1.0f);
+    psolaShifter.prepare(sampleRate, numChannels, static_cast<float>(sampleRate / AnalysisWorker::lowestFrequency), analysisFrontEnd.getNativeHopSize());
+    phaseVocoder.prepare(sampleRate, numChannels);
+    spectralDetector.prepare(sampleRate, phaseVocoder.getFrameSize(), minDetectableFrequency, maxDetectableFrequency);
+    jassert(spectralDetector.getFFTSize() == phaseVocoder.getFFTSize());
+    detectorRange = { minDetectableFrequency, maxDetectableFrequency };
+    hopMilliseconds = 1000.0f * (float)analysisFrontEnd.getNativeHopSize() / (float)sampleRate;
+    analysisWorker.prepare(sampleRate, analysisHopSeconds, maxDetectableFrequency);
+    if (isBackgroundAnalysisEnabled())
+        analysisWorker.start();
+    workerActive = false;
+
+    mixGain.reset(sampleRate, 0.02);
+    mixGain.setCurrentAndTargetValue(mixParameter.get());
+
+    // Lookahead detects across the whole window before the engine hears any of it
+    lookaheadSamples = analysisFrontEnd.getNativeWindowSize();
+    lookaheadActive = lookaheadParameter.get() >= 0.5f;
+    floatBuffers.lookaheadDelay.prepare(samplesPerBlock + lookaheadSamples, numChannels);
+    doubleBuffers.lookaheadDelay.prepare(samplesPerBlock + lookaheadSamples, numChannels);
+    detectionInput.assign((size_t)samplesPerBlock, 0.0f);
+    detectionSegment.assign((size_t)analysisFrontEnd.getNativeHopSize(), 0.0f);
+    pendingLatencySamples = getLatencyFor(getProcessingMode(), lookaheadActive);
+    setLatencySamples(pendingLatencySamples.load());
+
+    // The gate holds long enough for the delayed output to finish the note
+    const int gateHoldSamples = juce::roundToInt(0.02 * sampleRate) + phaseVocoder.getLatencySamples() + lookaheadSamples;
+    voicingGate.prepare(analysisFrontEnd.getAnalysisSampleRate(), gateHoldSamples / analysisFrontEnd.getNativeHopSize() + 1);
+    gateGain.reset(sampleRate, 0.01);
+    gateGain.setCurrentAndTargetValue(0.0f);
+    mixRamp.assign((size_t)samplesPerBlock, 1.0f);
+    floatBuffers.dryHistory.prepare(samplesPerBlock + phaseVocoder.getLatencySamples() + lookaheadSamples, numChannels);
+    doubleBuffers.dryHistory.prepare(samplesPerBlock + phaseVocoder.getLatencySamples() + lookaheadSamples, numChannels);
+
+    // At most a note-off, a bend and a note-on per hop, under 12 bytes each once packed
+    midiOutput.ensureSize((size_t)(36 * (samplesPerBlock / analysisFrontEnd.getNativeHopSize() + 2)));
+
+    for (auto& measurer : loadMeasurers)
+        measurer.reset(sampleRate, samplesPerBlock);
 }
 
 void AutotuneAudioProcessor::releaseResources()
 {
-    // Nothing to release yet
+    analysisWorker.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool AutotuneAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
-    // Support stereo in/out for simplicity
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-    if (layouts.getMainInputChannelSet() != juce::AudioChannelSet::stereo())
+    const auto input = layouts.getMainInputChannelSet();
+    const auto output = layouts.getMainOutputChannelSet();
+    if (input.isDisabled() || output.isDisabled() || input.size() > maxChannels)
         return false;
-    return true;
+
+    // Every channel is shifted by the same ratio, so any matching layout works; a mono
+    // input can also feed a stereo output, and is then processed once and copied
+    return output == input || (input == juce::AudioChannelSet::mono() && output == juce::AudioChannelSet::stereo());
 }
 #endif
 
+bool AutotuneAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 void AutotuneAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+void AutotuneAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void AutotuneAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    const juce::int64 blockStartTicks = logger.isEnabled(RealtimeLogger::timing) ? juce::Time::getHighResolutionTicks() : 0;
+    auto& dryHistory = getSampleBuffers<SampleType>().dryHistory;
+    auto& lookaheadDelay = getSampleBuffers<SampleType>().lookaheadDelay;
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
+    const int channels = juce::jmin(totalNumInputChannels, numChannels);
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    auto* leftChannelData = buffer.getWritePointer(0);
     int numSamples = buffer.getNumSamples();
 
-    // Pitch detection
-    int samplesToCopy = juce::jmin(numSamples, bufferSize);
-    for (int i = 0; i < samplesToCopy; ++i)
+    // The unprocessed input, for the mix; skipped if the host exceeds the block size it announced
+    const bool canMix = numSamples <= (int)mixRamp.size();
+    jassert(canMix);
+    if (canMix)
+        dryHistory.write(buffer.getArrayOfReadPointers(), numSamples, channels);
+
+    const auto mode = (ProcessingMode)engineParameter.getIndex();
+    if ((int)mode != activeProcessingMode)
     {
-        float window = 0.5f * (1.0f - cosf(2.0f * juce::MathConstants<float>::pi * i / (bufferSize - 1)));
-        analysisBuffer[i] = leftChannelData[i] * window;
+        activeProcessingMode = (int)mode;
+        analysisFrontEnd.reset();
+        psolaShifter.reset();
+        phaseVocoder.reset();
+        logger.log(RealtimeLogger::engine, mode == ProcessingMode::psola ? "Switched to PSOLA" : "Switched to the phase vocoder");
     }
-    for (int i = samplesToCopy; i < bufferSize; ++i)
-        analysisBuffer[i] = 0.0f;
 
-    float autocorr[bufferSize] = { 0 };
-    const int minPeriod = static_cast<int>(currentSampleRate / 1000.0);
-    const int maxPeriod = static_cast<int>(currentSampleRate / 50.0);
+    // Detection reads the input as it arrives while the engine is fed the delayed copy.
+    // Also off when the host exceeds its block size, as the scratch is sized for it.
+    const bool lookahead = canMix && lookaheadParameter.get() >= 0.5f;
+    if (lookahead != lookaheadActive)
+    {
+        lookaheadActive = lookahead;
+        lookaheadDelay.clear();
+    }
 
-    for (int lag = minPeriod; lag < maxPeriod; ++lag)
+    // setLatencySamples notifies the host synchronously, so a change is reported from the
+    // message thread; the dry path lines up with the engine from this block on regardless
+    const int latencySamples = getLatencyFor(mode, lookahead);
+    if (latencySamples != pendingLatencySamples.load(std::memory_order_relaxed))
     {
-        for (int i = 0; i < bufferSize - lag; ++i)
-        {
-            autocorr[lag] += analysisBuffer[i] * analysisBuffer[i + lag];
-        }
+        pendingLatencySamples.store(latencySamples, std::memory_order_relaxed);
+        triggerAsyncUpdate();
     }
 
-    float maxAutocorr = 0;
-    int period = minPeriod;
-    float threshold = 0.1f * autocorr[0];
-    for (int lag = minPeriod; lag < maxPeriod; ++lag)
+    // Detection runs once, on the mean of the channels, whatever the layout; null when the
+    // host exceeds its block size, in which case it is taken a segment at a time below
+    const float* detectionData = canMix ? getDetectionInput(buffer, numSamples, lookahead) : nullptr;
+    if (lookahead)
     {
-        if (autocorr[lag] > maxAutocorr && autocorr[lag] > threshold)
+        lookaheadDelay.write(buffer.getArrayOfReadPointers(), numSamples, channels);
+        for (int channel = 0; channel < channels; ++channel)
+            lookaheadDelay.read(channel, lookaheadDelay.getWritePosition() - numSamples - lookaheadSamples, buffer.getWritePointer(channel), numSamples);
+    }
+
+    followMidiNotes = targetModeParameter.getIndex() == (int)TargetMode::midiNotes;
+
+    // Switching the MIDI output off ends its note in this block's (otherwise empty) output
+    midiOutput.clear();
+    const bool emitMidi = midiOutputParameter.get() >= 0.5f;
+    if (midiOutputActive && !emitMidi)
+        pitchToMidi.stop(0, midiOutput);
+    const bool replaceMidi = midiOutputActive || emitMidi;
+    midiOutputActive = emitMidi;
+
+    updateScaleQuantiser();
+    psolaShifter.setQuality((InterpolationQuality)interpolationParameter.getIndex());
+    phaseVocoder.setFormantMode((FormantMode)formantsParameter.getIndex());
+    psolaShifter.setNumHarmonies(mode == ProcessingMode::psola ? harmonyVoicesParameter.getIndex() : 0);
+
+    const auto range = juce::Range<float>::between(minFrequencyParameter.get(), maxFrequencyParameter.get());
+    if (range != detectorRange)
+    {
+        detectorRange = range;
+        for (auto& detector : pitchDetectors)
+            detector->setFrequencyRange(range.getStart(), range.getEnd());
+        spectralDetector.setFrequencyRange(range.getStart(), range.getEnd());
+    }
+
+    juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadMeasurers[(size_t)mode], numSamples);
+    auto& detector = *pitchDetectors[(size_t)detectorParameter.getIndex()];
+
+    // A pitch map stands in for detection wherever the play head says where in the take
+    // we are.  The lock is only contended while setPitchMap swaps maps, and that block
+    // detects in real time instead.
+    const juce::SpinLock::ScopedTryLockType pitchMapScope(pitchMapLock);
+    const PitchMap* map = pitchMapScope.isLocked() && pitchMap != nullptr && pitchMap->getSampleRate() == currentSampleRate
+                              ? pitchMap.get() : nullptr;
+    juce::int64 takePosition = 0;           // Of the block's first sample
+    if (map != nullptr)
+    {
+        const auto position = getPlayHead() != nullptr ? getPlayHead()->getPosition() : juce::nullopt;
+        if (position.hasValue() && position->getTimeInSamples().hasValue())
+            takePosition = *position->getTimeInSamples() - pitchMapTakeStart;
+        else
+            map = nullptr;
+    }
+
+    // Background analysis hands detection to the worker; the hops below only pick up its
+    // newest estimate.  Its thread only runs while the mode is on, and is started and
+    // stopped from the message thread; until it is running, hops detect here as usual.
+    // Switching it on restarts the worker, which saw nothing meanwhile.
+    const bool backgroundAnalysis = backgroundAnalysisParameter.get() >= 0.5f;
+    if (backgroundAnalysis != analysisWorker.isRunning())
+        triggerAsyncUpdate();
+    const bool useWorker = map == nullptr && backgroundAnalysis && analysisWorker.isRunning();
+    if (useWorker && !workerActive)
+        analysisWorker.reset();
+    workerActive = useWorker;
+    if (useWorker)
+    {
+        // At the bottom of its range the lowest pitch leaves the worker's own floor in place
+        analysisWorker.setDetectorType(getPitchDetectorType());
+        analysisWorker.setFrequencyRange(range.getStart() <= minDetectableFrequency ? AnalysisWorker::lowestFrequency : range.getStart(),
+                                         range.getEnd());
+    }
+
+    // The autocorrelation detector can work from the vocoder's analysis spectra, so in
+    // that combination each hop is transformed once instead of twice; not with lookahead,
+    // where the vocoder only sees the delayed input
+    const bool detectFromVocoderFrames = mode == ProcessingMode::phaseVocoder && !lookahead && map == nullptr && !useWorker
+                                         && getPitchDetectorType() == PitchDetectorType::autocorrelation;
+
+    // Walk the block in segments that end on hop (and vocoder frame) boundaries, so
+    // detection runs every hop whatever the host's block size is, and on MIDI events,
+    // so a new target note takes effect on the event's own sample
+    auto nextEvent = midiMessages.cbegin();
+    mixGain.setTargetValue(mixParameter.get());
+    bool needsMix = false, engineRan = false;
+
+    for (int startSample = 0; startSample < numSamples;)
+    {
+        for (; nextEvent != midiMessages.cend() && (*nextEvent).samplePosition <= startSample; ++nextEvent)
+            handleMidiMessage((*nextEvent).getMessage());
+
+        int segmentLength = juce::jmin(numSamples - startSample, analysisFrontEnd.getSamplesUntilNextHop());
+        if (mode == ProcessingMode::phaseVocoder)
+            segmentLength = juce::jmin(segmentLength, phaseVocoder.getSamplesUntilNextFrame());
+        if (nextEvent != midiMessages.cend())
+            segmentLength = juce::jmin(segmentLength, (*nextEvent).samplePosition - startSample);
+
+        const float* segmentData = detectionData != nullptr ? detectionData + startSample
+                                                            : getDetectionSegment(buffer, startSample, segmentLength);
+        if (useWorker)
+            analysisWorker.push(segmentData, segmentLength);
+
+        const bool hopComplete = analysisFrontEnd.push(segmentData, segmentLength);
+        if (hopComplete)
+            voicingGate.measure(analysisFrontEnd.getWindow(), analysisFrontEnd.getWindowSize());
+
+        // Once the gate has faded out, the input passes straight through
+        const bool bypassed = canMix && !gateGain.isSmoothing() && gateGain.getCurrentValue() <= 0.0f;
+        if (canMix)
+            needsMix = fillMixRamp(startSample, segmentLength) || needsMix;
+
+        if (mode == ProcessingMode::psola)
         {
-            maxAutocorr = autocorr[lag];
-            period = lag;
+            if (bypassed)
+            {
+                pitchRatio.skip(segmentLength);
+                psolaShifter.bypass(buffer, startSample, segmentLength);
+            }
+            else
+            {
+                psolaShifter.process(buffer, startSample, segmentLength, pitchRatio);
+                engineRan = true;
+            }
+        }
+        else
+        {
+            pitchRatio.skip(segmentLength);
+            engineRan = true;
+
+            // The vocoder keeps running through unvoiced input to stay in step with its
+            // latency, but silent frames skip both transforms
+            if (phaseVocoder.process(buffer, startSample, segmentLength))
+            {
+                if (voicingGate.isAudible())
+                {
+                    phaseVocoder.analyseFrame();
+                    if (detectFromVocoderFrames)
+                        updatePitchRatio(spectralDetector.detectFromSpectrum(phaseVocoder.getMidSpectrum(), phaseVocoder.getMidFrameEnergy()),
+                                         startSample + segmentLength - 1);
+                    phaseVocoder.synthesiseFrame(pitchRatio.getTargetValue());
+                }
+                else
+                {
+                    phaseVocoder.skipFrame();
+                    if (detectFromVocoderFrames)
+                        updatePitchRatio({}, startSample + segmentLength - 1);
+                }
+            }
+        }
+
+        startSample += segmentLength;
+        inputPosition += segmentLength;
+
+        if (hopComplete && !detectFromVocoderFrames)
+        {
+            if (map != nullptr)
+                updatePitchRatio(map->getEstimate(takePosition + startSample), startSample - 1);
+            else if (useWorker)
+                updatePitchRatio(voicingGate.isAudible() ? analysisWorker.getLatest() : PitchEstimate {}, startSample - 1);
+            else
+                updatePitchRatio(voicingGate.isAudible() ? detector.detect(analysisFrontEnd.getWindow()) : PitchEstimate {}, startSample - 1);
         }
     }
 
-    float detectedFreq = (maxAutocorr > threshold) ? static_cast<float>(currentSampleRate / period) : 0.0f;
+    // Events the host stamped past the end of the block
+    for (; nextEvent != midiMessages.cend(); ++nextEvent)
+        handleMidiMessage((*nextEvent).getMessage());
 
-    // Adjust pitch smoothing with retune speed (hardcoded for now)
-    float retuneSpeed = 0.1f; // 0.0 = instant, 1.0 = no correction (will connect to slider later)
-    if (detectedFreq > 0.0f)
-        detectedFreq = (1.0f - retuneSpeed) * previousPitch + retuneSpeed * detectedFreq;
-    previousPitch = detectedFreq;
+    // Swapped rather than copied; the host's buffer becomes next block's storage
+    if (replaceMidi)
+        midiMessages.swapWith(midiOutput);
 
-    // Pitch correction to C major scale
-    float midiNote = (detectedFreq > 0.0f) ? 12.0f * log2f(detectedFreq / 440.0f) + 69.0f : 0.0f;
-    int targetNote = (midiNote > 0.0f) ? snapToCMajor(midiNote) : 0; // Snap to C major instead of chromatic
-    float targetFreq = (midiNote > 0.0f) ? 440.0f * powf(2.0f, (targetNote - 69.0f) / 12.0f) : 0.0f;
-    float pitchRatio = (detectedFreq > 0.0f && targetFreq > 0.0f) ? targetFreq / detectedFreq : 1.0f;
+    // A bypassed PSOLA block is already the input
+    if (needsMix && engineRan)
+        applyMix(buffer, numSamples, latencySamples);
 
-    DBG("Detected: " << detectedFreq << " Hz, Target: " << targetFreq << " Hz, Ratio: " << pitchRatio);
+    // Mono in, stereo out: the one processed channel goes to both sides
+    if (channels == 1)
+        for (int channel = 1; channel < totalNumOutputChannels; ++channel)
+            buffer.copyFrom(channel, 0, buffer, 0, 0, numSamples);
 
-    // Write input to circular buffer
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    // An overrun is a block that took longer to process than it lasts
+    if (blockStartTicks != 0)
+    {
+        const double elapsedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks);
+        const double blockSeconds = numSamples / currentSampleRate;
+        if (elapsedSeconds > blockSeconds)
+            logger.log(RealtimeLogger::timing, "Overrun: a %.0f-sample block took %.3f ms to process and lasts %.3f ms",
+                       (float)numSamples, (float)(elapsedSeconds * 1000.0), (float)(blockSeconds * 1000.0));
+    }
+}
+
+void AutotuneAudioProcessor::setPitchMap(std::unique_ptr<PitchMap> map, juce::int64 takeStartSample)
+{
+    // The old map is unmapped here, after the lock is released
+    {
+        const juce::SpinLock::ScopedLockType lock(pitchMapLock);
+        std::swap(pitchMap, map);
+        pitchMapTakeStart = takeStartSample;
+    }
+}
+
+PitchMap::AnalysisSettings AutotuneAudioProcessor::getPitchMapSettings() const
+{
+    PitchMap::AnalysisSettings settings;
+    settings.detector = getPitchDetectorType();
+    settings.windowSeconds = analysisWindowSeconds;
+    settings.hopSeconds = analysisHopSeconds;
+    settings.minFrequency = juce::jmin(minFrequencyParameter.get(), maxFrequencyParameter.get());
+    settings.maxFrequency = juce::jmax(minFrequencyParameter.get(), maxFrequencyParameter.get());
+    return settings;
+}
+
+int AutotuneAudioProcessor::getLatencyFor(ProcessingMode mode, bool lookahead) const noexcept
+{
+    return (lookahead ? lookaheadSamples : 0) + (mode == ProcessingMode::phaseVocoder ? phaseVocoder.getLatencySamples() : 0);
+}
+
+bool AutotuneAudioProcessor::fillMixRamp(int startSample, int numSamples) noexcept
+{
+    auto* ramp = mixRamp.data() + startSample;
+
+    if (mixGain.isSmoothing() || gateGain.isSmoothing())
     {
-        auto* inData = buffer.getWritePointer(channel);
-        auto* circData = circularBuffer.getWritePointer(channel);
         for (int i = 0; i < numSamples; ++i)
+            ramp[i] = mixGain.getNextValue() * gateGain.getNextValue();
+        return true;
+    }
+
+    // Fully corrected, the usual case, needs no mixing at all
+    const float gain = mixGain.getCurrentValue() * gateGain.getCurrentValue();
+    juce::FloatVectorOperations::fill(ramp, gain, numSamples);
+    return gain < 1.0f;
+}
+
+template <typename SampleType>
+void AutotuneAudioProcessor::applyMix(juce::AudioBuffer<SampleType>& buffer, int numSamples, int latencySamples) noexcept
+{
+    // out = dry + gain * (wet - dry), gain from fillMixRamp; the ramp is single precision,
+    // so doubles take a plain loop the compiler vectorises instead of the float routines
+    auto blend = [] (SampleType* wet, const SampleType* dry, const float* gain, int size)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
         {
-            int pos = (writePosition + i) % circularBuffer.getNumSamples();
-            circData[pos] = inData[i];
+            juce::FloatVectorOperations::subtract(wet, dry, size);
+            juce::FloatVectorOperations::multiply(wet, gain, size);
+            juce::FloatVectorOperations::add(wet, dry, size);
         }
+        else
+        {
+            for (int i = 0; i < size; ++i)
+                wet[i] = dry[i] + (SampleType)gain[i] * (wet[i] - dry[i]);
+        }
+    };
+
+    const auto& dryHistory = getSampleBuffers<SampleType>().dryHistory;
+
+    // The dry input is delayed by the engine's latency so the two line up
+    const auto dryStart = dryHistory.getWritePosition() - numSamples - latencySamples;
+    for (int channel = 0; channel < juce::jmin(buffer.getNumChannels(), dryHistory.getNumChannels()); ++channel)
+    {
+        const auto dry = dryHistory.getSpans(channel, dryStart, numSamples);
+        auto* wet = buffer.getWritePointer(channel);
+        blend(wet, dry.first, mixRamp.data(), dry.firstSize);
+        blend(wet + dry.firstSize, dry.second, mixRamp.data() + dry.firstSize, dry.secondSize);
     }
+}
 
-    // Read from circular buffer with pitch shift
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+template <typename SampleType>
+const float* AutotuneAudioProcessor::getDetectionInput(const juce::AudioBuffer<SampleType>& buffer, int numSamples, bool keepCopy) noexcept
+{
+    const int channels = juce::jmin(buffer.getNumChannels(), numChannels);
+    auto* mid = detectionInput.data();
+
+    if constexpr (std::is_same_v<SampleType, float>)
     {
-        auto* outData = buffer.getWritePointer(channel);
-        auto* circData = circularBuffer.getReadPointer(channel);
+        // A mono input is read in place unless the buffer is about to be overwritten
+        if (channels == 1 && !keepCopy)
+            return buffer.getReadPointer(0);
+
+        juce::FloatVectorOperations::copy(mid, buffer.getReadPointer(0), numSamples);
+        for (int channel = 1; channel < channels; ++channel)
+            juce::FloatVectorOperations::add(mid, buffer.getReadPointer(channel), numSamples);
+    }
+    else
+    {
+        // The detectors are single precision; the sum is taken in double and rounded once
         for (int i = 0; i < numSamples; ++i)
         {
-            int intPos = static_cast<int>(readPosition);
-            float frac = readPosition - intPos;
-            int nextPos = (intPos + 1) % circularBuffer.getNumSamples();
+            double sum = 0.0;
+            for (int channel = 0; channel < channels; ++channel)
+                sum += buffer.getReadPointer(channel)[i];
+            mid[i] = (float)sum;
+        }
+    }
+
+    // The mean rather than the sum, so the voicing gate's thresholds hold for any layout
+    if (channels > 1)
+        juce::FloatVectorOperations::multiply(mid, 1.0f / (float)channels, numSamples);
+
+    return mid;
+}
+
+template <typename SampleType>
+const float* AutotuneAudioProcessor::getDetectionSegment(const juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples) noexcept
+{
+    // Blocks over the announced size detect on the first channel, read in place when it
+    // is float; segments end on hops, so one hop of scratch holds a double one
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        return buffer.getReadPointer(0, startSample);
+    }
+    else
+    {
+        jassert(numSamples <= (int)detectionSegment.size());
+
+        const auto* input = buffer.getReadPointer(0, startSample);
+        for (int i = 0; i < numSamples; ++i)
+            detectionSegment[(size_t)i] = (float)input[i];
+        return detectionSegment.data();
+    }
+}
+
+void AutotuneAudioProcessor::updatePitchRatio(const PitchEstimate& detected, int sampleInBlock)
+{
+    // Unvoiced and silent hops correct nothing, and once the gate closes the engine fades out
+    const auto estimate = voicingGate.update(detected);
+    gateGain.setTargetValue(voicingGate.isOpen() ? 1.0f : 0.0f);
+
+    float detectedFreq = estimate.frequency;
+
+    // Grains follow the period actually present in the input, not the smoothed one
+    psolaShifter.setPeriod(estimate.frequency > 0.0f ? static_cast<float>(currentSampleRate / estimate.frequency) : 0.0f);
+
+    // Retune speed is the time constant of the tracked pitch; 0 ms follows every hop exactly.
+    // A note's first voiced hop starts the tracking at its own pitch rather than from 0.
+    const float retuneMilliseconds = retuneSpeedParameter.get();
+    const float retuneCoefficient = retuneMilliseconds > 0.0f ? 1.0f - std::exp(-hopMilliseconds / retuneMilliseconds) : 1.0f;
+    if (detectedFreq > 0.0f && previousPitch > 0.0f)
+        detectedFreq = (1.0f - retuneCoefficient) * previousPitch + retuneCoefficient * detectedFreq;
+    previousPitch = detectedFreq;
+
+    // Pitch correction to the selected key and scale, or to the held MIDI note
+    float midiNote = (detectedFreq > 0.0f) ? 12.0f * log2f(detectedFreq / 440.0f) + 69.0f : 0.0f;
+    int targetNote = getTargetNote(midiNote);
+    float targetFreq = (targetNote > 0) ? 440.0f * powf(2.0f, (targetNote - 69.0f) / 12.0f) : 0.0f;
+    float ratio = (detectedFreq > 0.0f && targetFreq > 0.0f) ? targetFreq / detectedFreq : 1.0f;
+
+    // Ramp to the new ratio across the next hop instead of stepping
+    pitchRatio.setTargetValue(ratio);
+
+    // Harmonies ramp from the same smoothed pitch to their own notes; silent ones follow the lead
+    const float harmonyLevel = harmonyLevelParameter.get();
+    for (int voice = 0; voice < harmonyVoicesParameter.getIndex(); ++voice)
+    {
+        const int harmonyNote = detectedFreq > 0.0f ? getHarmonyNote(voice, targetNote) : 0;
+        if (harmonyNote > 0)
+            psolaShifter.setHarmony(voice, 440.0f * powf(2.0f, (harmonyNote - 69.0f) / 12.0f) / detectedFreq, harmonyLevel);
+        else
+            psolaShifter.setHarmony(voice, ratio, 0.0f);
+    }
+
+    PitchTelemetryRecord record;
+    record.samplePosition = inputPosition;
+    record.detectedFrequency = estimate.frequency;
+    record.targetNote = (float)targetNote;
+    record.ratio = ratio;
+    record.confidence = estimate.confidence;
+    telemetry.push(record);
+
+    // Transcribe the raw estimate; smoothing is for the correction only
+    if (midiOutputActive)
+        pitchToMidi.process(estimate.frequency, estimate.confidence, sampleInBlock, midiOutput);
 
-            float sampleA = circData[intPos];
-            float sampleB = circData[nextPos];
-            outData[i] = sampleA + frac * (sampleB - sampleA);
+    logger.log(RealtimeLogger::pitch, "Detected %.2f Hz (confidence %.2f), target %.2f Hz, ratio %.4f",
+               detectedFreq, estimate.confidence, targetFreq, ratio);
+}
+
+int AutotuneAudioProcessor::getTargetNote(float midiNote) const
+{
+    if (midiNote <= 0.0f)
+        return 0;
+
+    return followMidiNotes ? juce::jmax(0, heldNotes.getTargetNote()) : scaleQuantiser.snap(midiNote);
+}
+
+int AutotuneAudioProcessor::getHarmonyNote(int voice, int leadNote) const
+{
+    if (harmonySourceParameter.getIndex() == (int)HarmonySource::midiNotes)
+        return juce::jmax(0, heldNotes.getHeldNote(voice));
+
+    return leadNote > 0 ? scaleQuantiser.snap((float)(leadNote + getHarmonyInterval(voice))) : 0;
+}
 
-            readPosition += pitchRatio;
-            if (readPosition >= circularBuffer.getNumSamples())
-                readPosition -= circularBuffer.getNumSamples();
+void AutotuneAudioProcessor::handleMidiMessage(const juce::MidiMessage& message)
+{
+    if (heldNotes.handle(message))
+    {
+        // Step straight to the new note's ratio from the current pitch estimate; the next
+        // hop ramps on from there as usual
+        if (followMidiNotes)
+        {
+            const float midiNote = (previousPitch > 0.0f) ? 12.0f * log2f(previousPitch / 440.0f) + 69.0f : 0.0f;
+            const int targetNote = getTargetNote(midiNote);
+            const float ratio = (targetNote > 0) ? 440.0f * powf(2.0f, (targetNote - 69.0f) / 12.0f) / previousPitch : 1.0f;
+            pitchRatio.setCurrentAndTargetValue(ratio);
         }
+
+        return;
     }
 
-    writePosition = (writePosition + numSamples) % circularBuffer.getNumSamples();
+    // Program change picks the scale, CC keyController/scaleController set the root and scale.
+    // Notifying the host isn't safe here, so the parameters follow from the message thread.
+    if (message.isProgramChange() && message.getProgramChangeNumber() < (int)ScaleType::numScales)
+        pendingMidiScale.store(message.getProgramChangeNumber(), std::memory_order_relaxed);
+    else if (message.isControllerOfType(keyController))
+        pendingMidiKey.store(message.getControllerValue() % 12, std::memory_order_relaxed);
+    else if (message.isControllerOfType(scaleController) && message.getControllerValue() < (int)ScaleType::numScales)
+        pendingMidiScale.store(message.getControllerValue(), std::memory_order_relaxed);
+    else
+        return;
+
+    updateScaleQuantiser();
+    triggerAsyncUpdate();
+}
+
+void AutotuneAudioProcessor::updateScaleQuantiser() noexcept
+{
+    // A key or scale set by MIDI stands in for its parameter until that has been published
+    const int midiKey = pendingMidiKey.load(std::memory_order_acquire);
+    const int midiScale = pendingMidiScale.load(std::memory_order_acquire);
+    scaleQuantiser.setScale(midiScale >= 0 ? (ScaleType)midiScale : getScale(), midiKey >= 0 ? midiKey : getKey(),
+                            (uint16_t)customScaleMask.load());
+}
+
+void AutotuneAudioProcessor::handleAsyncUpdate()
+{
+    const int latencySamples = pendingLatencySamples.load(std::memory_order_relaxed);
+    if (latencySamples != getLatencySamples())
+        setLatencySamples(latencySamples);
+
+    // Does nothing before prepareToPlay or after releaseResources
+    if (isBackgroundAnalysisEnabled())
+        analysisWorker.start();
+    else
+        analysisWorker.stop();
+
+    // The parameter is set before the pending value is cleared, so the audio thread never
+    // falls back to the old one; a newer MIDI value that arrived meanwhile stays pending
+    int midiKey = pendingMidiKey.load(std::memory_order_relaxed);
+    if (midiKey >= 0)
+    {
+        setKey(midiKey);
+        pendingMidiKey.compare_exchange_strong(midiKey, -1, std::memory_order_release, std::memory_order_relaxed);
+    }
+
+    int midiScale = pendingMidiScale.load(std::memory_order_relaxed);
+    if (midiScale >= 0)
+    {
+        setScale((ScaleType)midiScale);
+        pendingMidiScale.compare_exchange_strong(midiScale, -1, std::memory_order_release, std::memory_order_relaxed);
+    }
 }
 
 //==============================================================================
@@ -216,12 +791,22 @@ juce::AudioProcessorEditor* AutotuneAudioProcessor::createEditor()
 //==============================================================================
 void AutotuneAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    // Add parameter saving later
+    // Binary ValueTree: smaller and quicker to parse than the usual XML
+    auto state = parameters.copyState();
+    state.setProperty("customScaleMask", customScaleMask.load(), nullptr);
+
+    juce::MemoryOutputStream stream(destData, false);
+    state.writeToStream(stream);
 }
 
 void AutotuneAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // Add parameter loading later
+    const auto state = juce::ValueTree::readFromData(data, (size_t)sizeInBytes);
+    if (!state.isValid() || !state.hasType(parameters.state.getType()))
+        return;
+
+    customScaleMask.store((int)state.getProperty("customScaleMask", customScaleMask.load()) & 0xfff);
+    parameters.replaceState(state);
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
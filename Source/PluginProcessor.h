@@ -9,11 +9,69 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PitchDetector.h"
+#include "PitchTelemetry.h"
+#include "RealtimeLogger.h"
+#include "ScaleQuantiser.h"
+#include "MidiNoteTracker.h"
+#include "PitchToMidiConverter.h"
+#include "VoicingGate.h"
+#include "PitchMap.h"
+#include "PitchAnalysisFrontEnd.h"
+#include "RingBuffer.h"
+#include "PsolaShifter.h"
+#include "PhaseVocoderShifter.h"
+#include "AutocorrelationPitchDetector.h"
+#include "AnalysisWorker.h"
+
+enum class ProcessingMode
+{
+    psola = 0,                              // Time-domain grains, best for monophonic voice
+    phaseVocoder,                           // Frequency-domain, for polyphonic or noisy material
+    numModes
+};
+
+enum class TargetMode
+{
+    scale = 0,                              // Nearest note of the selected key and scale
+    midiNotes,                              // The held MIDI note, switched on the event's sample
+    numModes
+};
+
+enum class HarmonySource
+{
+    intervals = 0,                          // Scale-snapped intervals above the corrected note
+    midiNotes,                              // Voice n sings the n-th held MIDI note
+    numSources
+};
+
+namespace ParameterIDs
+{
+    inline constexpr const char* retuneSpeed = "retuneSpeed";
+    inline constexpr const char* key = "key";
+    inline constexpr const char* scale = "scale";
+    inline constexpr const char* mix = "mix";
+    inline constexpr const char* engine = "engine";
+    inline constexpr const char* detector = "detector";
+    inline constexpr const char* minFrequency = "minFrequency";
+    inline constexpr const char* maxFrequency = "maxFrequency";
+    inline constexpr const char* targetMode = "targetMode";
+    inline constexpr const char* midiOutput = "midiOutput";
+    inline constexpr const char* interpolation = "interpolation";
+    inline constexpr const char* lookahead = "lookahead";
+    inline constexpr const char* harmonyVoices = "harmonyVoices";
+    inline constexpr const char* harmonySource = "harmonySource";
+    inline constexpr const char* harmonyLevel = "harmonyLevel";
+    inline constexpr const char* formants = "formants";
+    inline constexpr const char* backgroundAnalysis = "backgroundAnalysis";
+    inline constexpr const char* harmonyIntervals[] = { "harmonyInterval1", "harmonyInterval2", "harmonyInterval3", "harmonyInterval4" };
+}
 
 //==============================================================================
 /**
 */
-class AutotuneAudioProcessor : public juce::AudioProcessor
+class AutotuneAudioProcessor : public juce::AudioProcessor,
+                               private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -28,7 +86,10 @@ public:
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 #endif
 
+    // Both precisions run the same core, instantiated for each sample type
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -52,35 +113,217 @@ public:
     //==============================================================================
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
-    float getPreviousPitch() const { return previousPitch; }
-    float previousPitch;                    // Track pitch for smoothing
+
+    // Host-automatable parameters; the setters and getters below are shortcuts to them
+    juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    void setPitchDetectorType(PitchDetectorType type) { detectorParameter.set((float)type); }
+    PitchDetectorType getPitchDetectorType() const { return (PitchDetectorType)detectorParameter.getIndex(); }
+    const char* getPitchDetectorName(PitchDetectorType type) const { return pitchDetectors[(size_t)type]->getName(); }
+
+    void setProcessingMode(ProcessingMode mode) { engineParameter.set((float)mode); }
+    ProcessingMode getProcessingMode() const { return (ProcessingMode)engineParameter.getIndex(); }
+    double getProcessingLoad(ProcessingMode mode) const { return loadMeasurers[(size_t)mode].getLoadAsPercentage(); }
+
+    // How finely PSOLA grains interpolate the input; draft for tracking, high for the bounce
+    void setInterpolationQuality(InterpolationQuality quality) { interpolationParameter.set((float)quality); }
+    InterpolationQuality getInterpolationQuality() const { return (InterpolationQuality)interpolationParameter.getIndex(); }
+
+    // Phase vocoder formant preservation; fast for tracking, high for the bounce.  PSOLA
+    // keeps formants by construction and ignores it.
+    void setFormantMode(FormantMode mode) { formantsParameter.set((float)mode); }
+    FormantMode getFormantMode() const { return (FormantMode)formantsParameter.getIndex(); }
+
+    // Delays the audio by the analysis window so corrections land on note onsets; the
+    // delay is reported to the host.  Off, only the phase vocoder adds latency.
+    void setLookaheadEnabled(bool shouldBeEnabled) { lookaheadParameter.set(shouldBeEnabled ? 1.0f : 0.0f); }
+    bool isLookaheadEnabled() const { return lookaheadParameter.get() >= 0.5f; }
+
+    // Detects on a background thread over a window long enough for bass voices, down to
+    // AnalysisWorker::lowestFrequency when the lowest pitch is at the bottom of its range.
+    // The audio thread only queues input and reads the newest estimate.
+    void setBackgroundAnalysisEnabled(bool shouldBeEnabled) { backgroundAnalysisParameter.set(shouldBeEnabled ? 1.0f : 0.0f); }
+    bool isBackgroundAnalysisEnabled() const { return backgroundAnalysisParameter.get() >= 0.5f; }
+
+    // Extra PSOLA voices shifted from the same detection; the vocoder renders the lead only
+    void setHarmonyVoices(int numVoices) { harmonyVoicesParameter.set((float)juce::jlimit(0, PsolaShifter::maxHarmonies, numVoices)); }
+    int getHarmonyVoices() const { return harmonyVoicesParameter.getIndex(); }
+    void setHarmonySource(HarmonySource source) { harmonySourceParameter.set((float)source); }
+    HarmonySource getHarmonySource() const { return (HarmonySource)harmonySourceParameter.getIndex(); }
+    void setHarmonyInterval(int voice, int semitones) { harmonyIntervalParameters[(size_t)voice].set((float)semitones); }
+    int getHarmonyInterval(int voice) const { return juce::roundToInt(harmonyIntervalParameters[(size_t)voice].get()); }
+
+    // Analysis window and hop in seconds; takes effect on the next prepareToPlay
+    void setAnalysisWindow(double windowSeconds, double hopSeconds) { analysisWindowSeconds = windowSeconds; analysisHopSeconds = hopSeconds; }
+    double getAnalysisWindowSeconds() const { return analysisWindowSeconds; }
+    double getAnalysisHopSeconds() const { return analysisHopSeconds; }
+
+    // Input samples the window actually spans once prepared, rounded through the decimated
+    // rate, and the worker's longer one while background analysis is on
+    int getAnalysisWindowSamples() const
+    {
+        return isBackgroundAnalysisEnabled() ? analysisWorker.getNativeWindowSize() : analysisFrontEnd.getNativeWindowSize();
+    }
+
+    // A pre-analysed contour of the take being played; while one is set and the play head
+    // reports a position, hops read it instead of detecting.  takeStartSample is where the
+    // take's first sample lies on the play head's timeline; outside the take, hops are
+    // unvoiced.  For offline rendering such as BatchRender, which knows both; the plugin
+    // itself never sets one.  Message thread; nullptr clears.
+    void setPitchMap(std::unique_ptr<PitchMap> map, juce::int64 takeStartSample = 0);
+    bool hasPitchMap() const { return pitchMap != nullptr; }
+
+    // Analysis settings that make a PitchMap match what this processor would detect
+    PitchMap::AnalysisSettings getPitchMapSettings() const;
+
+    // Key (0 = C) and scale the corrected pitch snaps to; not from the audio thread.  MIDI
+    // changes them on the audio thread at once and in the parameters shortly after.
+    void setKey(int root) { keyParameter.set((float)(((root % 12) + 12) % 12)); }
+    int getKey() const { return keyParameter.getIndex(); }
+    void setScale(ScaleType type) { scaleParameter.set((float)type); }
+    ScaleType getScale() const { return (ScaleType)scaleParameter.getIndex(); }
+    void setCustomScaleMask(uint16_t mask) { customScaleMask.store(mask & 0xfff); } // Bit n = n semitones above the key
+    uint16_t getCustomScaleMask() const { return (uint16_t)customScaleMask.load(); }
+
+    // Where the corrected pitch comes from; with no MIDI note held, midiNotes passes the input through
+    void setTargetMode(TargetMode mode) { targetModeParameter.set((float)mode); }
+    TargetMode getTargetMode() const { return (TargetMode)targetModeParameter.getIndex(); }
+
+    // Replaces the MIDI output with notes and pitch bend following the detected pitch
+    void setMidiOutputEnabled(bool shouldBeEnabled) { midiOutputParameter.set(shouldBeEnabled ? 1.0f : 0.0f); }
+    bool isMidiOutputEnabled() const { return midiOutputParameter.get() >= 0.5f; }
+
+    // Input channels the engines process; a mono input feeding a stereo output is processed once
+    static constexpr int maxChannels = PsolaShifter::maxChannels;
+    static_assert(maxChannels == PhaseVocoderShifter::maxChannels, "Both engines must take every supported layout");
+
+    static constexpr int keyController = 14;    // CC value % 12 sets the key
+    static constexpr int scaleController = 15;  // CC value selects a ScaleType, as does program change
+
+    // One record per analysis hop; drained by the editor on the message thread
+    PitchTelemetryFifo& getTelemetry() { return telemetry; }
+
+    // Off by default in release builds; enable categories and start() it to capture a session
+    RealtimeLogger& getLogger() { return logger; }
    
 private:
     //==============================================================================
-    static const int bufferSize = 2048;     // Size of buffer for pitch analysis
-    float analysisBuffer[bufferSize];       // Buffer to hold audio samples for analysis
+    // A parameter and its plain value, looked up once so the audio thread never searches by ID
+    struct CachedParameter
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+        std::atomic<float>* value = nullptr;
+
+        float get() const noexcept { return value->load(std::memory_order_relaxed); }
+        int getIndex() const noexcept { return (int)get(); }
+        void set(float newValue) { parameter->setValueNotifyingHost(parameter->convertTo0to1(newValue)); }
+    };
+
+    juce::AudioProcessorValueTreeState parameters;
+    CachedParameter retuneSpeedParameter;   // Milliseconds for the tracked pitch to settle
+    CachedParameter keyParameter;
+    CachedParameter scaleParameter;
+    CachedParameter mixParameter;           // 0 = input only, 1 = corrected only
+    CachedParameter engineParameter;        // ProcessingMode
+    CachedParameter detectorParameter;      // PitchDetectorType
+    CachedParameter minFrequencyParameter;  // Detector search range, Hz
+    CachedParameter maxFrequencyParameter;
+    CachedParameter targetModeParameter;
+    CachedParameter midiOutputParameter;
+    CachedParameter interpolationParameter; // InterpolationQuality
+    CachedParameter lookaheadParameter;
+    CachedParameter formantsParameter;      // FormantMode
+    CachedParameter backgroundAnalysisParameter;
+    CachedParameter harmonyVoicesParameter;
+    CachedParameter harmonySourceParameter; // HarmonySource
+    CachedParameter harmonyLevelParameter;  // Gain of each harmony voice
+    std::array<CachedParameter, PsolaShifter::maxHarmonies> harmonyIntervalParameters; // Semitones
+
+    static constexpr float minDetectableFrequency = 50.0f;     // Range the detectors are prepared for;
+    static constexpr float maxDetectableFrequency = 1000.0f;   // the parameters narrow it
+
+    float previousPitch;                    // Track pitch for smoothing, audio thread only
+    static constexpr double defaultWindowSeconds = 0.046;  // Two periods at 43 Hz
+    static constexpr double defaultHopSeconds = 0.0058;
+    double analysisWindowSeconds;           // Configured analysis window
+    double analysisHopSeconds;              // Configured spacing between detections
+    PitchAnalysisFrontEnd analysisFrontEnd; // Decimates to ~16 kHz and signals every hop
+    juce::LinearSmoothedValue<float> pitchRatio; // Ramped from one hop's ratio to the next
+    std::array<std::unique_ptr<PitchDetector>, (size_t)PitchDetectorType::numTypes> pitchDetectors; // One per engine, all prepared
     double currentSampleRate;               // Store the sample rate for calculations
-    juce::AudioBuffer<float> circularBuffer;// Circular buffer for pitch shifting
-    int writePosition;                      // Current position in circular buffer
-    float readPosition;                     // Fractional read position for shifting
-   
-    bool isInCMajorScale(int note)
+    PsolaShifter psolaShifter;              // Grain-based shifter driven by the detected period
+    PhaseVocoderShifter phaseVocoder;       // Spectral shifter for ProcessingMode::phaseVocoder
+    AutocorrelationPitchDetector spectralDetector; // Detects straight from the vocoder's analysis spectra
+    int activeProcessingMode;               // Mode of the previous block, audio thread only
+    juce::int64 inputPosition;              // Samples processed since prepareToPlay, for telemetry
+    std::array<juce::AudioProcessLoadMeasurer, (size_t)ProcessingMode::numModes> loadMeasurers;
+    PitchTelemetryFifo telemetry;           // Audio thread -> editor
+    RealtimeLogger logger;                  // Audio thread -> log file
+    std::atomic<int> customScaleMask;       // Pitch classes of ScaleType::custom, saved with the state
+    ScaleQuantiser scaleQuantiser;          // Audio thread copy of key, scale and the above
+    bool followMidiNotes;                   // targetModeParameter for the current block, audio thread only
+    MidiNoteTracker heldNotes;              // Notes held on the MIDI input, audio thread only
+    bool midiOutputActive;                  // midiOutputParameter for the current block, audio thread only
+    PitchToMidiConverter pitchToMidi;       // Detected pitch -> MIDI output
+    juce::MidiBuffer midiOutput;            // Preallocated, swapped with the host's buffer
+    float hopMilliseconds;                  // Native hop length, for the retune time constant
+    juce::Range<float> detectorRange;       // Range the detectors were last narrowed to, audio thread only
+    juce::SmoothedValue<float> mixGain;     // Per-sample wet gain
+    VoicingGate voicingGate;                // Skips detection on silence, bypasses unvoiced hops
+    juce::SmoothedValue<float> gateGain;    // Crossfade between the engine (1) and the input (0)
+    std::vector<float> mixRamp;             // mixGain * gateGain for one block, preallocated
+    // Audio held at the host's precision; both are prepared, the host's one is used
+    template <typename SampleType>
+    struct SampleBuffers
     {
-        int noteInOctave = note % 12;
-        return noteInOctave == 0 || noteInOctave == 2 || noteInOctave == 4 ||
-            noteInOctave == 5 || noteInOctave == 7 || noteInOctave == 9 || noteInOctave == 11; // C D E F G A B
-    }
+        RingBuffer<SampleType, maxChannels> dryHistory;     // Input, delayed to line up with the engine's output
+        RingBuffer<SampleType, maxChannels> lookaheadDelay; // Input on its way to the engine when lookahead is on
+    };
+
+    SampleBuffers<float> floatBuffers;
+    SampleBuffers<double> doubleBuffers;
+    std::vector<float> detectionInput;      // Undelayed mean of the input channels for one block, preallocated
+    std::vector<float> detectionSegment;    // One hop of a double input, for blocks over the announced size
+    int numChannels;                        // Input channels, all processed, at most maxChannels
+    int lookaheadSamples;                   // Native analysis window, the lookahead delay
+    std::unique_ptr<PitchMap> pitchMap;     // Replaces detection when set
+    juce::int64 pitchMapTakeStart = 0;      // Timeline sample of the map's first frame, set with it
+    juce::SpinLock pitchMapLock;            // Held by setPitchMap to swap, tried by processBlock
+    bool lookaheadActive;                   // lookaheadParameter for the current block, audio thread only
+    AnalysisWorker analysisWorker;          // Long-window detection off the audio thread
+    bool workerActive;                      // Whether the previous block fed the worker, audio thread only
+    std::atomic<int> pendingLatencySamples; // Latency the audio thread needs, reported by handleAsyncUpdate
+    std::atomic<int> pendingMidiKey;        // Set by MIDI, -1 once handleAsyncUpdate has published it
+    std::atomic<int> pendingMidiScale;      // ScaleType set by MIDI, likewise
 
-    int snapToCMajor(float midiNote)
+    CachedParameter cacheParameter(const char* parameterID);
+    int getLatencyFor(ProcessingMode mode, bool lookahead) const noexcept;
+    bool fillMixRamp(int startSample, int numSamples) noexcept;
+
+    template <typename SampleType>
+    SampleBuffers<SampleType>& getSampleBuffers() noexcept
     {
-        int nearest = static_cast<int>(roundf(midiNote));
-        while (!isInCMajorScale(nearest) && nearest > 0 && nearest < 127)
-        {
-            if (midiNote > nearest) nearest++;
-            else nearest--;
-        }
-        return nearest;
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleBuffers;
+        else
+            return floatBuffers;
     }
 
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+    template <typename SampleType>
+    void applyMix(juce::AudioBuffer<SampleType>& buffer, int numSamples, int latencySamples) noexcept;
+    template <typename SampleType>
+    const float* getDetectionInput(const juce::AudioBuffer<SampleType>& buffer, int numSamples, bool keepCopy) noexcept;
+    template <typename SampleType>
+    const float* getDetectionSegment(const juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples) noexcept;
+    void updatePitchRatio(const PitchEstimate& detected, int sampleInBlock);
+    int getTargetNote(float midiNote) const;
+    int getHarmonyNote(int voice, int leadNote) const;
+    void handleMidiMessage(const juce::MidiMessage& message);
+    void updateScaleQuantiser() noexcept;
+    void handleAsyncUpdate() override;
+   
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutotuneAudioProcessor)
 };
\ No newline at end of file
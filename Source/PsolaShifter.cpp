@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    PsolaShifter.cpp
+
+  ==============================================================================
+*/
+
+#include "PsolaShifter.h"
+
+void PsolaShifter::prepare(double newSampleRate, int newNumChannels, float newMaxPeriod, int maxBlockSize)
+{
+    jassert(newNumChannels <= maxChannels);
+
+    numChannels = juce::jmin(newNumChannels, maxChannels);
+    sampleRate = newSampleRate;
+    maxPeriod = newMaxPeriod;
+    unvoicedPeriod = static_cast<float>(sampleRate / 200.0);
+
+    // A whole block is written ahead of the grains reading it, and a grain may start
+    // up to two periods in the past and run for two more, plus the interpolator's taps
+    const int historySize = maxBlockSize + static_cast<int>(std::ceil(4.0f * maxPeriod)) + SincInterpolator::maxTaps + 4;
+    history.prepare(historySize, numChannels);
+    doubleHistory.prepare(historySize, numChannels);
+    interpolator.prepare();
+
+    // Periodic Hann: windows of length 2T spaced T apart sum to one
+    for (int i = 0; i <= windowTableSize; ++i)
+        window[(size_t)i] = 0.5f * (1.0f - std::cos(juce::MathConstants<float>::twoPi * i / windowTableSize));
+
+    for (auto& voice : voices)
+        voice.ratio.reset(maxBlockSize);
+
+    reset();
+}
+
+void PsolaShifter::reset() noexcept
+{
+    history.clear();
+    doubleHistory.clear();
+    numActiveGrains = 0;
+    period = 0.0f;
+    time = 0;
+    analysisMark = 0.0;
+
+    for (auto& voice : voices)
+    {
+        voice.nextSynthesisMark = 0.0;
+        voice.ratio.setCurrentAndTargetValue(1.0f);
+    }
+}
+
+void PsolaShifter::setPeriod(float periodInSamples) noexcept
+{
+    period = periodInSamples > 0.0f ? juce::jlimit(2.0f, maxPeriod, periodInSamples) : 0.0f;
+}
+
+void PsolaShifter::setQuality(InterpolationQuality newQuality) noexcept
+{
+    if (newQuality == quality)
+        return;
+
+    quality = newQuality;
+    for (int g = 0; g < numActiveGrains; ++g)
+        grains[(size_t)g].coefficients = interpolator.getCoefficients(quality, grains[(size_t)g].fraction);
+}
+
+void PsolaShifter::setNumHarmonies(int numHarmonies) noexcept
+{
+    const int newNumVoices = juce::jlimit(0, maxHarmonies, numHarmonies) + 1;
+    for (int v = numVoices; v < newNumVoices; ++v)
+    {
+        voices[(size_t)v].nextSynthesisMark = (double)time;
+        voices[(size_t)v].ratio.setCurrentAndTargetValue(1.0f);
+        voices[(size_t)v].gain = 0.0f;
+    }
+
+    numVoices = newNumVoices;
+}
+
+void PsolaShifter::setHarmony(int index, float ratio, float gain) noexcept
+{
+    jassert(index >= 0 && index < maxHarmonies);
+
+    auto& voice = voices[(size_t)index + 1];
+    voice.ratio.setTargetValue(ratio);
+    voice.gain = gain;
+}
+
+void PsolaShifter::startGrain(Voice& voice, juce::int64 outputTime, float ratio) noexcept
+{
+    const double grainPeriod = period > 0.0f ? period : unvoicedPeriod;
+
+    // Resynchronise if marks fell behind, e.g. after the pool was exhausted
+    if (voice.nextSynthesisMark < (double)outputTime - 1.0)
+        voice.nextSynthesisMark = (double)outputTime;
+
+    // Newest analysis mark that is not in the future
+    if (analysisMark > (double)outputTime || analysisMark + 4.0 * maxPeriod < (double)outputTime)
+        analysisMark = (double)outputTime;
+    while (analysisMark + grainPeriod <= (double)outputTime)
+        analysisMark += grainPeriod;
+
+    if (numActiveGrains < maxGrains && voice.gain > 0.0f)
+    {
+        // Starting on an integer sample late by (outputTime - mark) is compensated by
+        // reading the source that much later, which keeps fractional mark spacing exact
+        auto& grain = grains[(size_t)numActiveGrains++];
+        grain.length = juce::jmax(2, juce::roundToInt(2.0 * grainPeriod));
+        const double sourcePosition = analysisMark - grainPeriod + ((double)outputTime - voice.nextSynthesisMark);
+        const double whole = std::floor(sourcePosition);
+        grain.sourcePosition = static_cast<juce::int64>(whole);
+        grain.fraction = static_cast<float>(sourcePosition - whole);
+        grain.coefficients = interpolator.getCoefficients(quality, grain.fraction);
+        grain.age = 0;
+        grain.windowStep = (float)windowTableSize / (float)grain.length;
+        grain.gain = voice.gain;
+    }
+
+    voice.nextSynthesisMark += grainPeriod / (period > 0.0f ? ratio : 1.0f);
+}
+
+template <typename SampleType>
+void PsolaShifter::bypass(const juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples) noexcept
+{
+    const int channels = juce::jmin(buffer.getNumChannels(), numChannels);
+
+    const SampleType* input[maxChannels] = {};
+    for (int channel = 0; channel < channels; ++channel)
+        input[channel] = buffer.getReadPointer(channel, startSample);
+    getHistory<SampleType>().write(input, numSamples, channels);
+
+    // Grains in flight would be cut off mid-window; the caller has already faded them out
+    numActiveGrains = 0;
+    time += numSamples;
+    for (int v = 0; v < numVoices; ++v)
+    {
+        voices[(size_t)v].nextSynthesisMark = (double)time;
+        voices[(size_t)v].ratio.skip(numSamples);
+    }
+}
+
+template <typename SampleType>
+void PsolaShifter::process(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples,
+                           juce::LinearSmoothedValue<float>& ratio) noexcept
+{
+    const int channels = juce::jmin(buffer.getNumChannels(), numChannels);
+    auto* const* io = buffer.getArrayOfWritePointers();
+
+    // Grains never read past the sample being output, so the whole block can go into
+    // the history up front as two block copies per channel
+    const SampleType* input[maxChannels] = {};
+    for (int channel = 0; channel < channels; ++channel)
+        input[channel] = io[channel] + startSample;
+    getHistory<SampleType>().write(input, numSamples, channels);
+
+    switch (quality)
+    {
+        case InterpolationQuality::draft:
+            renderGrains<SampleType, SincInterpolator::getNumTaps(InterpolationQuality::draft)>(io, channels, startSample, numSamples, ratio);
+            break;
+
+        case InterpolationQuality::high:
+            renderGrains<SampleType, SincInterpolator::getNumTaps(InterpolationQuality::high)>(io, channels, startSample, numSamples, ratio);
+            break;
+
+        case InterpolationQuality::normal:
+        default:
+            renderGrains<SampleType, SincInterpolator::getNumTaps(InterpolationQuality::normal)>(io, channels, startSample, numSamples, ratio);
+            break;
+    }
+}
+
+template <typename SampleType, int NumTaps>
+void PsolaShifter::renderGrains(SampleType* const* io, int channels, int startSample, int numSamples,
+                                juce::LinearSmoothedValue<float>& ratio) noexcept
+{
+    // Grains read at least a period behind the output, so the taps after the read
+    // position are always already in the history.  Every voice's grains are in the one
+    // pool, so the history is read in a single pass whatever the number of voices.
+    const auto& source = getHistory<SampleType>();
+    const SampleType* hist[maxChannels] = {};
+    for (int channel = 0; channel < channels; ++channel)
+        hist[channel] = source.getReadPointer(channel);
+    const int historyMask = source.getMask();
+    const int historySize = source.getCapacity();
+
+    for (int i = startSample; i < startSample + numSamples; ++i, ++time)
+    {
+        const float leadRatio = juce::jlimit(minRatio, maxRatio, ratio.getNextValue());
+        if ((double)time >= voices[0].nextSynthesisMark)
+            startGrain(voices[0], time, leadRatio);
+
+        for (int v = 1; v < numVoices; ++v)
+        {
+            auto& voice = voices[(size_t)v];
+            const float voiceRatio = juce::jlimit(minRatio, maxRatio, voice.ratio.getNextValue());
+            if ((double)time >= voice.nextSynthesisMark)
+                startGrain(voice, time, voiceRatio);
+        }
+
+        for (int channel = 0; channel < channels; ++channel)
+            io[channel][i] = 0;
+
+        for (int g = 0; g < numActiveGrains;)
+        {
+            auto& grain = grains[(size_t)g];
+
+            const int firstTap = static_cast<int>((grain.sourcePosition + grain.age - (NumTaps / 2 - 1)) & historyMask);
+            const auto gain = (SampleType)(grain.gain * window[(size_t)(grain.age * grain.windowStep)]);
+
+            // Taps are contiguous except where they straddle the wrap, which is the same for
+            // every channel, so the channel loop below is one read per channel
+            const bool wraps = firstTap > historySize - NumTaps;
+
+            for (int channel = 0; channel < channels; ++channel)
+            {
+                const SampleType* taps = hist[channel] + firstTap;
+                SampleType wrapped[NumTaps];
+                if (wraps)
+                {
+                    for (int t = 0; t < NumTaps; ++t)
+                        wrapped[t] = hist[channel][(firstTap + t) & historyMask];
+                    taps = wrapped;
+                }
+
+                io[channel][i] += gain * SincInterpolator::read<NumTaps>(taps, grain.coefficients);
+            }
+
+            if (++grain.age >= grain.length)
+                grain = grains[(size_t)--numActiveGrains];
+            else
+                ++g;
+        }
+    }
+}
+
+template void PsolaShifter::process(juce::AudioBuffer<float>&, int, int, juce::LinearSmoothedValue<float>&) noexcept;
+template void PsolaShifter::process(juce::AudioBuffer<double>&, int, int, juce::LinearSmoothedValue<float>&) noexcept;
+template void PsolaShifter::bypass(const juce::AudioBuffer<float>&, int, int) noexcept;
+template void PsolaShifter::bypass(const juce::AudioBuffer<double>&, int, int) noexcept;
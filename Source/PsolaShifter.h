@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    PsolaShifter.h
+
+    Time-domain pitch-synchronous overlap-add.  Grains two periods long are
+    cut from the input history around analysis marks spaced one detected
+    period apart, Hann-windowed from a precomputed table, and overlap-added at
+    synthesis marks spaced period / ratio apart.  Grains are records in a
+    fixed pool that read straight from the history, so nothing is copied or
+    allocated and the per-sample cost is bounded by maxGrains.  A grain's
+    fractional source offset is fixed for its life, so its windowed-sinc
+    taps are looked up once when it starts.
+
+    Up to maxHarmonies harmony voices can be added to the lead.  They share
+    the history, the analysis marks and the grain pool, and only keep their
+    own synthesis marks and ratio, so one per-sample pass over the pool
+    renders every voice.
+
+    process() and bypass() take float or double buffers.  Each precision has
+    its own history and its own instantiation of the grain loop, so a 64-bit
+    host's audio is never converted; the window and interpolator tables stay
+    single precision, being coefficients rather than signal.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RingBuffer.h"
+#include "SincInterpolator.h"
+
+class PsolaShifter
+{
+public:
+    static constexpr float minRatio = 0.25f;
+    static constexpr float maxRatio = 4.0f;
+    static constexpr int maxChannels = 8;   // Up to 7.1
+    static constexpr int maxHarmonies = 4;
+
+    PsolaShifter() = default;
+
+    // maxPeriod is the longest period, in native samples, that setPeriod will be given;
+    // maxBlockSize is the longest range process() will be given, and harmony ratios ramp
+    // across that many samples.
+    void prepare(double sampleRate, int numChannels, float maxPeriod, int maxBlockSize);
+    void reset() noexcept;
+
+    // Detected period in native samples, or 0 for unvoiced input.
+    void setPeriod(float periodInSamples) noexcept;
+
+    // Interpolator tier the grains read the history with; grains in flight switch too.
+    void setQuality(InterpolationQuality newQuality) noexcept;
+
+    // Harmony voices to render with the lead; added ones start on the next sample.
+    void setNumHarmonies(int numHarmonies) noexcept;
+
+    // Ramps harmony index to ratio (relative to the input) across the next maxBlockSize
+    // samples.  New grains take the gain; 0 lets the voice fade out with its grains.
+    void setHarmony(int index, float ratio, float gain) noexcept;
+
+    // Shifts buffer[startSample, startSample + numSamples) in place, taking one ratio step per
+    // sample, and adds the harmonies.
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples,
+                 juce::LinearSmoothedValue<float>& ratio) noexcept;
+
+    // Leaves buffer[startSample, startSample + numSamples) as it is, only recording it in
+    // the history so grains can start straight away when process() is called again.
+    template <typename SampleType>
+    void bypass(const juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    struct Grain
+    {
+        juce::int64 sourcePosition = 0; // Absolute input position of the grain's first sample, rounded down
+        float fraction = 0.0f;          // and the offset past it, constant for the grain's life
+        const float* coefficients = nullptr; // Interpolator taps for fraction
+        int length = 0;
+        int age = 0;
+        float windowStep = 0.0f;        // Window table increment per output sample
+        float gain = 1.0f;              // Of the voice that started it
+    };
+
+    struct Voice
+    {
+        double nextSynthesisMark = 0.0;
+        float gain = 1.0f;
+        juce::LinearSmoothedValue<float> ratio; // Harmonies only; the caller owns the lead's
+    };
+
+    static constexpr int maxVoices = maxHarmonies + 1;
+    static constexpr int maxGrainsPerVoice = 2 * static_cast<int>(maxRatio) + 2;
+    static constexpr int maxGrains = maxGrainsPerVoice * maxVoices;
+    static constexpr int windowTableSize = 1024;
+
+    void startGrain(Voice& voice, juce::int64 outputTime, float ratio) noexcept;
+
+    template <typename SampleType, int NumTaps>
+    void renderGrains(SampleType* const* io, int channels, int startSample, int numSamples,
+                      juce::LinearSmoothedValue<float>& ratio) noexcept;
+
+    // Both are prepared; only the one for the host's precision is written
+    template <typename SampleType>
+    RingBuffer<SampleType, maxChannels>& getHistory() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleHistory;
+        else
+            return history;
+    }
+
+    RingBuffer<float, maxChannels> history;
+    RingBuffer<double, maxChannels> doubleHistory;
+    int numChannels = 0;
+    std::array<float, windowTableSize + 1> window {};
+    std::array<Grain, maxGrains> grains;
+    int numActiveGrains = 0;
+    SincInterpolator interpolator;
+    InterpolationQuality quality = InterpolationQuality::normal;
+    std::array<Voice, maxVoices> voices;    // [0] is the lead
+    int numVoices = 1;
+
+    double sampleRate = 44100.0;
+    float maxPeriod = 0.0f;
+    float unvoicedPeriod = 0.0f;        // Grain spacing used when nothing is detected
+    float period = 0.0f;
+    juce::int64 time = 0;               // Current output time, in input samples
+    double analysisMark = 0.0;          // Shared by every voice
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PsolaShifter)
+};
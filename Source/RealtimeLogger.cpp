@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    RealtimeLogger.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeLogger.h"
+
+RealtimeLogger::RealtimeLogger()
+    : juce::Thread("Realtime logger")
+{
+    records.resize((size_t)queueSize);
+}
+
+RealtimeLogger::~RealtimeLogger()
+{
+    stop();
+}
+
+bool RealtimeLogger::start(const juce::File& logFile)
+{
+    stop();
+
+    auto newStream = std::make_unique<juce::FileOutputStream>(logFile);
+    if (newStream->failedToOpen())
+        return false;
+
+    stream = std::move(newStream);
+    return startThread(juce::Thread::Priority::background);
+}
+
+void RealtimeLogger::stop()
+{
+    stopThread(1000);
+    if (stream != nullptr)
+        drain();
+    stream.reset();
+}
+
+void RealtimeLogger::setCategoryEnabled(Category category, bool shouldBeEnabled) noexcept
+{
+    if (shouldBeEnabled)
+        enabledCategories.fetch_or(category, std::memory_order_relaxed);
+    else
+        enabledCategories.fetch_and(~(uint32_t)category, std::memory_order_relaxed);
+}
+
+void RealtimeLogger::push(Category category, const char* format, float v0, float v1, float v2, float v3) noexcept
+{
+    const auto scope = fifo.write(1);
+
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+    {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& record = records[(size_t)(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+    record.ticks = juce::Time::getHighResolutionTicks();
+    record.format = format;
+    record.category = category;
+    record.values[0] = v0;
+    record.values[1] = v1;
+    record.values[2] = v2;
+    record.values[3] = v3;
+}
+
+void RealtimeLogger::run()
+{
+    while (!threadShouldExit())
+    {
+        drain();
+        wait(50);
+    }
+}
+
+void RealtimeLogger::drain()
+{
+    const auto scope = fifo.read(fifo.getNumReady());
+
+    auto write = [this](const Record& record)
+    {
+        char text[256];
+        // Arguments beyond those the format consumes are evaluated and ignored
+        std::snprintf(text, sizeof(text), record.format,
+                      (double)record.values[0], (double)record.values[1], (double)record.values[2], (double)record.values[3]);
+
+        const char* name = record.category == pitch ? "pitch" : record.category == engine ? "engine" : "timing";
+        *stream << juce::String(juce::Time::highResolutionTicksToSeconds(record.ticks), 6) << " [" << name << "] " << text << juce::newLine;
+    };
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        write(records[(size_t)(scope.startIndex1 + i)]);
+    for (int i = 0; i < scope.blockSize2; ++i)
+        write(records[(size_t)(scope.startIndex2 + i)]);
+
+    const uint32_t dropped = numDropped.load(std::memory_order_relaxed);
+    if (dropped != reportedDropped)
+    {
+        *stream << "[logger] " << (int)(dropped - reportedDropped) << " records dropped" << juce::newLine;
+        reportedDropped = dropped;
+    }
+
+    if (scope.blockSize1 + scope.blockSize2 > 0)
+        stream->flush();
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    RealtimeLogger.h
+
+    Logging that is safe to call from the audio thread.  log() copies a
+    fixed-size binary record into a lock-free queue; a background thread
+    formats the records and appends them to a file.  Each category has an
+    enable bit, so a disabled log() costs one load and one branch.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class RealtimeLogger : private juce::Thread
+{
+public:
+    enum Category : uint32_t
+    {
+        pitch       = 1u << 0,              // Per-hop detection and correction results
+        engine      = 1u << 1,              // Mode switches, resets, preparation
+        timing      = 1u << 2               // Blocks that overrun their own duration
+    };
+
+    static constexpr int maxValues = 4;
+    static constexpr int queueSize = 4096;
+
+    RealtimeLogger();
+    ~RealtimeLogger() override;
+
+    // Opens (appending to) the file and starts the writer thread.  Not real-time safe.
+    bool start(const juce::File& logFile);
+    void stop();
+
+    void setCategoryEnabled(Category category, bool shouldBeEnabled) noexcept;
+    bool isEnabled(Category category) const noexcept { return (enabledCategories.load(std::memory_order_relaxed) & category) != 0; }
+
+    /** Audio thread.  `format` must be a string literal (only the pointer is queued)
+        containing up to maxValues floating-point conversions such as %f or %.1f.
+    */
+    void log(Category category, const char* format, float v0 = 0.0f, float v1 = 0.0f, float v2 = 0.0f, float v3 = 0.0f) noexcept
+    {
+        if (!isEnabled(category))
+            return;
+
+        push(category, format, v0, v1, v2, v3);
+    }
+
+    // Records lost because the writer thread fell behind
+    uint32_t getNumDropped() const noexcept { return numDropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Record
+    {
+        juce::int64 ticks;
+        const char* format;
+        Category category;
+        float values[maxValues];
+    };
+
+    void push(Category category, const char* format, float v0, float v1, float v2, float v3) noexcept;
+    void run() override;
+    void drain();
+
+    std::atomic<uint32_t> enabledCategories { 0 };
+    std::atomic<uint32_t> numDropped { 0 };
+    juce::AbstractFifo fifo { queueSize };
+    std::vector<Record> records;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    uint32_t reportedDropped = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeLogger)
+};
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    RingBuffer.h
+
+    Multichannel history with power-of-two capacity.  Positions are absolute
+    sample counts and are wrapped with a mask, never a modulo.  A write or a
+    read of any length touches at most two contiguous spans per channel, so
+    block copies go through FloatVectorOperations instead of a per-sample
+    loop, and callers that need the data in place can use getSpans().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename SampleType, int NumChannels>
+class RingBuffer
+{
+public:
+    static_assert(NumChannels > 0, "RingBuffer needs at least one channel");
+
+    // A range of the history split where it wraps; second is empty when it doesn't.
+    struct Spans
+    {
+        const SampleType* first;
+        int firstSize;
+        const SampleType* second;
+        int secondSize;
+    };
+
+    RingBuffer() = default;
+
+    // Allocates at least minimumCapacity samples for each of the first numChannels
+    // channels, so a mono layout only pays for one, and clears.
+    void prepare(int minimumCapacity, int numChannels = NumChannels)
+    {
+        jassert(numChannels > 0 && numChannels <= NumChannels);
+
+        const int capacity = juce::nextPowerOfTwo(juce::jmax(2, minimumCapacity));
+        storage.setSize(juce::jlimit(1, NumChannels, numChannels), capacity);
+        mask = capacity - 1;
+        clear();
+    }
+
+    void clear() noexcept
+    {
+        storage.clear();
+        numWritten = 0;
+    }
+
+    int getCapacity() const noexcept { return mask + 1; }
+    int getNumChannels() const noexcept { return storage.getNumChannels(); }
+    int getMask() const noexcept { return mask; }
+
+    // Absolute position one past the newest sample.
+    juce::int64 getWritePosition() const noexcept { return numWritten; }
+
+    // Appends numSamples from the first numSourceChannels channels of source.
+    void write(const SampleType* const* source, int numSamples, int numSourceChannels = NumChannels) noexcept
+    {
+        jassert(numSamples <= getCapacity() && numSourceChannels <= getNumChannels());
+
+        const int start = static_cast<int>(numWritten & mask);
+        const int firstSize = juce::jmin(numSamples, getCapacity() - start);
+
+        for (int channel = 0; channel < numSourceChannels; ++channel)
+        {
+            auto* destination = storage.getWritePointer(channel);
+            juce::FloatVectorOperations::copy(destination + start, source[channel], firstSize);
+            juce::FloatVectorOperations::copy(destination, source[channel] + firstSize, numSamples - firstSize);
+        }
+
+        numWritten += numSamples;
+    }
+
+    // Wrap-free view of [position, position + numSamples) of one channel.
+    Spans getSpans(int channel, juce::int64 position, int numSamples) const noexcept
+    {
+        jassert(numSamples <= getCapacity());
+
+        const auto* data = storage.getReadPointer(channel);
+        const int start = static_cast<int>(position & mask);
+        const int firstSize = juce::jmin(numSamples, getCapacity() - start);
+        return { data + start, firstSize, data, numSamples - firstSize };
+    }
+
+    // Copies [position, position + numSamples) of one channel into a linear buffer.
+    void read(int channel, juce::int64 position, SampleType* destination, int numSamples) const noexcept
+    {
+        const auto spans = getSpans(channel, position, numSamples);
+        juce::FloatVectorOperations::copy(destination, spans.first, spans.firstSize);
+        juce::FloatVectorOperations::copy(destination + spans.firstSize, spans.second, spans.secondSize);
+    }
+
+    SampleType getSample(int channel, juce::int64 position) const noexcept
+    {
+        return storage.getReadPointer(channel)[position & mask];
+    }
+
+    // Raw storage for hot loops that wrap indices with getMask() themselves.
+    const SampleType* getReadPointer(int channel) const noexcept { return storage.getReadPointer(channel); }
+
+private:
+    juce::AudioBuffer<SampleType> storage;
+    int mask = 0;
+    juce::int64 numWritten = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RingBuffer)
+};
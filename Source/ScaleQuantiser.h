@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    ScaleQuantiser.h
+
+    Snaps a fractional MIDI note to the nearest note of a key and scale in
+    constant time.  The tables for every root and built-in scale are
+    generated at compile time; each entry holds the nearest in-scale note at
+    or below and at or above one MIDI note, and snap() picks the closer of
+    the two.  A custom scale gets its own table, rebuilt in place (no
+    allocation) only when its mask changes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum class ScaleType
+{
+    major = 0,
+    naturalMinor,
+    harmonicMinor,
+    melodicMinor,
+    dorian,
+    phrygian,
+    lydian,
+    mixolydian,
+    locrian,
+    chromatic,
+    majorPentatonic,
+    minorPentatonic,
+    blues,
+    custom,                                 // Any set of pitch classes, see ScaleQuantiser::setScale
+    numScales
+};
+
+namespace ScaleTables
+{
+    static constexpr int numBuiltInScales = (int)ScaleType::custom;
+    static constexpr uint8_t noNote = 0xff;
+
+    // Bit n set means the note n semitones above the root is in the scale
+    static constexpr uint16_t masks[numBuiltInScales] =
+    {
+        0b101010110101,                     // major             C D E F G A B
+        0b010110101101,                     // natural minor     C D Eb F G Ab Bb
+        0b100110101101,                     // harmonic minor    C D Eb F G Ab B
+        0b101010101101,                     // melodic minor     C D Eb F G A B
+        0b011010101101,                     // dorian            C D Eb F G A Bb
+        0b010110101011,                     // phrygian          C Db Eb F G Ab Bb
+        0b101011010101,                     // lydian            C D E F# G A B
+        0b011010110101,                     // mixolydian        C D E F G A Bb
+        0b010101101011,                     // locrian           C Db Eb F Gb Ab Bb
+        0b111111111111,                     // chromatic
+        0b001010010101,                     // major pentatonic  C D E G A
+        0b010010101001,                     // minor pentatonic  C Eb F G Bb
+        0b010011101001                      // blues             C Eb F F# G Bb
+    };
+
+    struct SnapTable
+    {
+        std::array<uint8_t, 128> below {};  // Nearest in-scale note <= n, or noNote
+        std::array<uint8_t, 128> above {};  // Nearest in-scale note >= n, or noNote
+    };
+
+    constexpr bool contains(uint16_t mask, int root, int note)
+    {
+        return (mask >> ((note - root + 120) % 12)) & 1;
+    }
+
+    constexpr SnapTable makeSnapTable(uint16_t mask, int root)
+    {
+        SnapTable table {};
+        uint8_t last = noNote;
+        for (int note = 0; note < 128; ++note)
+        {
+            if (contains(mask, root, note))
+                last = (uint8_t)note;
+            table.below[(size_t)note] = last;
+        }
+
+        last = noNote;
+        for (int note = 127; note >= 0; --note)
+        {
+            if (contains(mask, root, note))
+                last = (uint8_t)note;
+            table.above[(size_t)note] = last;
+        }
+
+        return table;
+    }
+
+    constexpr std::array<std::array<SnapTable, 12>, numBuiltInScales> makeAllSnapTables()
+    {
+        std::array<std::array<SnapTable, 12>, numBuiltInScales> tables {};
+        for (int scale = 0; scale < numBuiltInScales; ++scale)
+            for (int root = 0; root < 12; ++root)
+                tables[(size_t)scale][(size_t)root] = makeSnapTable(masks[scale], root);
+
+        return tables;
+    }
+
+    inline constexpr auto snapTables = makeAllSnapTables();
+
+    inline const char* getScaleName(ScaleType type)
+    {
+        static constexpr const char* names[] = { "Major", "Natural minor", "Harmonic minor", "Melodic minor", "Dorian", "Phrygian",
+                                                 "Lydian", "Mixolydian", "Locrian", "Chromatic", "Major pentatonic", "Minor pentatonic",
+                                                 "Blues", "Custom" };
+        return names[(size_t)type];
+    }
+}
+
+//==============================================================================
+class ScaleQuantiser
+{
+public:
+    ScaleQuantiser() { setScale(ScaleType::major, 0, 0); }
+
+    /** Selects the key and scale.  customMask (bit n = n semitones above the root)
+        is only used for ScaleType::custom; an empty mask behaves as chromatic.
+        Real-time safe: built-in scales just repoint, a custom one rebuilds 128 entries.
+    */
+    void setScale(ScaleType type, int root, uint16_t customMask) noexcept
+    {
+        root = ((root % 12) + 12) % 12;
+
+        if (type == ScaleType::custom)
+        {
+            customMask &= 0xfff;
+            if (customMask == 0)
+                customMask = ScaleTables::masks[(int)ScaleType::chromatic];
+
+            if (customMask != builtCustomMask || root != builtCustomRoot)
+            {
+                customTable = ScaleTables::makeSnapTable(customMask, root);
+                builtCustomMask = customMask;
+                builtCustomRoot = root;
+            }
+
+            table = &customTable;
+        }
+        else
+        {
+            table = &ScaleTables::snapTables[(size_t)type][(size_t)root];
+        }
+    }
+
+    // Nearest in-scale MIDI note to a fractional one
+    int snap(float midiNote) const noexcept
+    {
+        const int note = juce::jlimit(0, 127, juce::roundToInt(midiNote));
+        const int below = table->below[(size_t)note];
+        const int above = table->above[(size_t)note];
+
+        if (below == ScaleTables::noNote)
+            return above;
+        if (above == ScaleTables::noNote)
+            return below;
+
+        return (midiNote - (float)below) <= ((float)above - midiNote) ? below : above;
+    }
+
+private:
+    const ScaleTables::SnapTable* table = nullptr;
+    ScaleTables::SnapTable customTable;
+    uint16_t builtCustomMask = 0;
+    int builtCustomRoot = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScaleQuantiser)
+};
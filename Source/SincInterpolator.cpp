@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    SincInterpolator.cpp
+
+  ==============================================================================
+*/
+
+#include "SincInterpolator.h"
+
+void SincInterpolator::prepare()
+{
+    static_assert(getNumTaps(InterpolationQuality::draft) == 4, "The draft kernel is a 4-point cubic");
+
+    for (int q = 0; q < (int)InterpolationQuality::numQualities; ++q)
+    {
+        const int numTaps = getNumTaps((InterpolationQuality)q);
+        const double halfWidth = 0.5 * numTaps;
+        auto& table = tables[(size_t)q];
+        table.assign((size_t)((numPhases + 1) * numTaps), 0.0f);
+
+        for (int phase = 0; phase <= numPhases; ++phase)
+        {
+            auto* row = table.data() + (size_t)(phase * numTaps);
+            const double fraction = (double)phase / numPhases;
+
+            // Catmull-Rom through the samples before, at, after and two after the position;
+            // its weights already sum to one
+            if (q == (int)InterpolationQuality::draft)
+            {
+                const double t = fraction, t2 = t * t, t3 = t2 * t;
+                row[0] = (float)(0.5 * (-t3 + 2.0 * t2 - t));
+                row[1] = (float)(0.5 * (3.0 * t3 - 5.0 * t2 + 2.0));
+                row[2] = (float)(0.5 * (-3.0 * t3 + 4.0 * t2 + t));
+                row[3] = (float)(0.5 * (t3 - t2));
+                continue;
+            }
+
+            double sum = 0.0;
+
+            for (int tap = 0; tap < numTaps; ++tap)
+            {
+                // Distance from the read position to this tap's sample, Blackman-windowed sinc.
+                // Grains read at the input rate, so the cutoff stays at Nyquist.
+                const double x = (double)(numTaps / 2 - 1 - tap) + fraction;
+                const double u = juce::MathConstants<double>::pi * x / halfWidth;
+                const double windowGain = std::abs(x) < halfWidth ? 0.42 + 0.5 * std::cos(u) + 0.08 * std::cos(2.0 * u) : 0.0;
+                const double sinc = x == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+
+                row[tap] = (float)(sinc * windowGain);
+                sum += sinc * windowGain;
+            }
+
+            // Unity gain at DC for every phase, so the fraction doesn't modulate the level
+            for (int tap = 0; tap < numTaps; ++tap)
+                row[tap] = (float)(row[tap] / sum);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    SincInterpolator.h
+
+    Polyphase windowed-sinc tables for reading the history at a fractional
+    position.  Each quality tier has its own tap count; a table row holds the
+    taps for one of numPhases fractional offsets, so reading a sample is a
+    dot product of contiguous arrays with no trigonometry.  Four taps are
+    too few for a windowed sinc to beat linear interpolation, so the draft
+    tier's rows hold a cubic Hermite (Catmull-Rom) kernel instead.  The tap count is
+    a template argument of read(), so the compiler unrolls and vectorises the
+    loop for each tier and each sample type.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum class InterpolationQuality
+{
+    draft = 0,                              // 4-tap cubic, for tracking on a busy session
+    normal,                                 // 8 taps
+    high,                                   // 32 taps, for the final bounce
+    numQualities
+};
+
+class SincInterpolator
+{
+public:
+    static constexpr int numPhases = 256;
+    static constexpr int maxTaps = 32;
+
+    static constexpr int getNumTaps(InterpolationQuality quality) noexcept
+    {
+        return quality == InterpolationQuality::draft ? 4 : quality == InterpolationQuality::normal ? 8 : maxTaps;
+    }
+
+    SincInterpolator() = default;
+
+    // Builds the tables of every tier, so switching tiers later costs nothing.
+    void prepare();
+
+    // The numTaps coefficients for a fractional offset in [0, 1].  The first one
+    // applies to the sample numTaps / 2 - 1 before the integer position.
+    const float* getCoefficients(InterpolationQuality quality, float fraction) const noexcept
+    {
+        const int phase = juce::jlimit(0, numPhases, juce::roundToInt(fraction * (float)numPhases));
+        return tables[(size_t)quality].data() + (size_t)(phase * getNumTaps(quality));
+    }
+
+    // Dot product of NumTaps contiguous samples with a row from getCoefficients(),
+    // accumulated at the samples' precision.
+    template <int NumTaps, typename SampleType>
+    static SampleType read(const SampleType* samples, const float* coefficients) noexcept
+    {
+        SampleType sum = 0;
+        for (int i = 0; i < NumTaps; ++i)
+            sum += samples[i] * (SampleType)coefficients[i];
+        return sum;
+    }
+
+private:
+    // numPhases + 1 rows each, the last being a whole sample on
+    std::array<std::vector<float>, (size_t)InterpolationQuality::numQualities> tables;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SincInterpolator)
+};
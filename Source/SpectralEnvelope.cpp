@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    SpectralEnvelope.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectralEnvelope.h"
+
+void SpectralEnvelope::prepare(double sampleRate, int fftSize)
+{
+    static_assert(fastDecimation == 4, "The fast path's FFT order assumes a decimation of 4");
+    jassert(juce::isPowerOfTwo(fftSize) && fftSize >= 16 * fastDecimation);
+
+    int order = 0;
+    while ((1 << order) < fftSize)
+        ++order;
+
+    // The lifter stops short of the shortest pitch period the detectors look for (1 kHz),
+    // so harmonics are smoothed away and only the formants remain
+    const int highOrder = juce::jmax(8, juce::roundToInt(0.7 * sampleRate / 1000.0));
+
+    paths[0].fft = std::make_unique<juce::dsp::FFT>(order - 2);
+    paths[0].decimation = fastDecimation;
+    paths[0].order = juce::jmin(highOrder / 2, fftSize / fastDecimation / 2 - 1);
+
+    paths[1].fft = std::make_unique<juce::dsp::FFT>(order);
+    paths[1].decimation = 1;
+    paths[1].order = juce::jmin(highOrder, fftSize / 2 - 1);
+
+    numBins = fftSize / 2 + 1;
+    cepstrum.assign((size_t)(2 * fftSize), 0.0f);
+    envelope.assign((size_t)numBins, 1.0f);
+}
+
+void SpectralEnvelope::estimate(const float* magnitude, FormantMode mode) noexcept
+{
+    jassert(mode != FormantMode::off);
+
+    auto& path = paths[mode == FormantMode::fast ? 0 : 1];
+    const int size = path.fft->getSize();
+    const int bins = size / 2 + 1;
+    const int decimation = path.decimation;
+
+    // Log magnitude of each group of bins as the real parts of a half spectrum
+    std::fill(cepstrum.begin(), cepstrum.begin() + 2 * size, 0.0f);
+    for (int b = 0; b < bins; ++b)
+    {
+        const int first = b * decimation;
+        const int last = juce::jmin(numBins, first + decimation);
+        float sum = 0.0f;
+        for (int k = first; k < last; ++k)
+            sum += magnitude[k];
+
+        cepstrum[(size_t)(2 * b)] = std::log(sum / (float)juce::jmax(1, last - first) + magnitudeFloor);
+    }
+
+    path.fft->performRealOnlyInverseTransform(cepstrum.data());
+
+    // Lifter: keep the low quefrencies, symmetrically, so the envelope stays real
+    std::fill(cepstrum.begin() + path.order + 1, cepstrum.begin() + size - path.order, 0.0f);
+    std::fill(cepstrum.begin() + size, cepstrum.begin() + 2 * size, 0.0f);
+
+    path.fft->performRealOnlyForwardTransform(cepstrum.data(), true);
+
+    // Back to linear magnitude, interpolated up to every bin on the fast path
+    for (int b = 0; b < bins; ++b)
+        cepstrum[(size_t)b] = std::exp(cepstrum[(size_t)(2 * b)]);
+
+    if (decimation == 1)
+    {
+        std::copy(cepstrum.begin(), cepstrum.begin() + numBins, envelope.begin());
+        return;
+    }
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        // Each group's value belongs to its centre
+        const float position = juce::jlimit(0.0f, (float)(bins - 1), ((float)k - 0.5f * (float)(decimation - 1)) / (float)decimation);
+        const int index = juce::jmin((int)position, bins - 2);
+        const float fraction = position - (float)index;
+        envelope[(size_t)k] = cepstrum[(size_t)index] + fraction * (cepstrum[(size_t)index + 1] - cepstrum[(size_t)index]);
+    }
+}
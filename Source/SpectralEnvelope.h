@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    SpectralEnvelope.h
+
+    Cepstral estimate of the smooth spectral envelope (the formants) of one
+    analysis frame, so a shifter can move the partials and then put the
+    envelope back where it was.  The log magnitude spectrum is transformed
+    to the cepstrum, liftered to its low quefrencies and transformed back.
+    The fast path first averages the spectrum in groups of fastDecimation
+    bins and keeps half the coefficients, which cuts both transforms to a
+    quarter of the size; the high path works at full resolution.  All
+    buffers are allocated in prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum class FormantMode
+{
+    off = 0,                                // Formants move with the pitch
+    fast,                                   // Low-order envelope, for tracking
+    high,                                   // High-order envelope, for rendering
+    numModes
+};
+
+class SpectralEnvelope
+{
+public:
+    SpectralEnvelope() = default;
+
+    // fftSize is that of the spectra whose magnitudes are given to estimate().
+    void prepare(double sampleRate, int fftSize);
+
+    // Estimates the envelope of fftSize / 2 + 1 bin magnitudes.  mode must not be off.
+    void estimate(const float* magnitude, FormantMode mode) noexcept;
+
+    // Linear envelope per bin, valid after estimate().
+    const float* getEnvelope() const noexcept { return envelope.data(); }
+
+private:
+    static constexpr int fastDecimation = 4;
+    static constexpr float magnitudeFloor = 1.0e-9f;
+
+    struct Path
+    {
+        std::unique_ptr<juce::dsp::FFT> fft;
+        int decimation = 1;
+        int order = 0;                      // Cepstral coefficients kept either side of 0
+    };
+
+    std::array<Path, 2> paths;              // fast, high
+    std::vector<float> cepstrum;            // 2 * fftSize, shared by both paths
+    std::vector<float> envelope;            // fftSize / 2 + 1
+    int numBins = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectralEnvelope)
+};
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+    Hands the newest value of T from one writer thread to one reader thread
+    without locks or waiting.  Each side owns a slot; the third sits in the
+    middle.  The writer fills its slot and swaps it into the middle, the
+    reader swaps the middle out only when it has been refreshed.  Values the
+    reader never collected are simply replaced, so it always sees the latest
+    complete value, never a torn one, and neither side can stall the other.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    // Sets every slot; only while neither thread is using the buffer.
+    void reset(const T& value = {}) noexcept
+    {
+        slots.fill(value);
+        middle.store(1, std::memory_order_relaxed);
+        back = 0;
+        front = 2;
+    }
+
+    // Writer thread.
+    void write(const T& value) noexcept
+    {
+        slots[(size_t)back] = value;
+        back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Reader thread.  The newest value written, or the last one read if nothing is new.
+    const T& read() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) != 0)
+            front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+
+        return slots[(size_t)front];
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshBit = 4;      // Set in middle when the writer has swapped in a new value
+
+    std::array<T, 3> slots {};
+    std::atomic<int> middle { 1 };
+    int back = 0;                           // Writer only
+    int front = 2;                          // Reader only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TripleBuffer)
+};
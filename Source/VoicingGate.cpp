@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    VoicingGate.cpp
+
+  ==============================================================================
+*/
+
+#include "VoicingGate.h"
+
+void VoicingGate::prepare(double analysisSampleRate, int newHoldHops)
+{
+    openLevel = juce::square(juce::Decibels::decibelsToGain(openLevelDb));
+    closeLevel = juce::square(juce::Decibels::decibelsToGain(closeLevelDb));
+    maxCrossingsPerSample = (float)(maxVoicedCrossingRate / analysisSampleRate);
+    holdHops = juce::jmax(0, newHoldHops);
+    reset();
+}
+
+void VoicingGate::reset() noexcept
+{
+    audible = false;
+    noisy = false;
+    open = false;
+    unvoicedHops = 0;
+    lastVoiced = {};
+}
+
+bool VoicingGate::measure(const float* window, int windowSize) noexcept
+{
+    float sumOfSquares = 0.0f;
+    int crossings = 0;
+    for (int i = 0; i < windowSize; ++i)
+    {
+        sumOfSquares += window[i] * window[i];
+        crossings += (i > 0 && (window[i] >= 0.0f) != (window[i - 1] >= 0.0f)) ? 1 : 0;
+    }
+
+    const float meanSquare = sumOfSquares / (float)juce::jmax(1, windowSize);
+    audible = meanSquare >= (audible ? closeLevel : openLevel);
+    noisy = (float)crossings > maxCrossingsPerSample * (float)windowSize;
+    return audible;
+}
+
+PitchEstimate VoicingGate::update(const PitchEstimate& estimate) noexcept
+{
+    const bool voiced = audible && !noisy && estimate.frequency > 0.0f
+                        && estimate.confidence >= (open ? closeConfidence : openConfidence);
+
+    if (voiced)
+    {
+        open = true;
+        unvoicedHops = 0;
+        lastVoiced = estimate;
+        return estimate;
+    }
+
+    if (open && ++unvoicedHops > holdHops)
+    {
+        open = false;
+        lastVoiced = {};
+    }
+
+    // Held open through a short dropout, the note carries on at its last voiced pitch, so
+    // the correction and grain spacing don't jump for one hop
+    return lastVoiced;
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    VoicingGate.h
+
+    Decides per analysis hop whether the input is silent, unvoiced (breaths,
+    sibilants, noise) or voiced, so the processor can skip detection on
+    silence and hand unvoiced material through untouched.  Level and
+    confidence each have separate open and close thresholds, and the gate
+    closes only after holdHops unvoiced hops in a row, so it doesn't chatter
+    on a note's decay or between syllables.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PitchDetector.h"
+
+class VoicingGate
+{
+public:
+    VoicingGate() = default;
+
+    // analysisSampleRate is the rate of the windows given to measure()
+    void prepare(double analysisSampleRate, int holdHops);
+    void reset() noexcept;
+
+    // Level and zero-crossing rate of a hop's analysis window.  Returns false when
+    // the window is silent, in which case detection can be skipped.
+    bool measure(const float* window, int windowSize) noexcept;
+    bool isAudible() const noexcept { return audible; }
+
+    // Applies the voicing decision to the hop's estimate: returns it unchanged when it is
+    // voiced, the last voiced estimate while the gate is held open through a dropout, and
+    // an unvoiced estimate once the gate has closed.
+    PitchEstimate update(const PitchEstimate& estimate) noexcept;
+    bool isOpen() const noexcept { return open; }
+
+private:
+    static constexpr float openLevelDb = -50.0f;       // RMS of the analysis window
+    static constexpr float closeLevelDb = -56.0f;
+    static constexpr float openConfidence = 0.5f;
+    static constexpr float closeConfidence = 0.3f;
+    static constexpr double maxVoicedCrossingRate = 4000.0;    // Zero crossings per second; above is sibilance
+
+    float openLevel = 0.0f;                 // Mean squares for the dB thresholds
+    float closeLevel = 0.0f;
+    float maxCrossingsPerSample = 0.0f;
+    int holdHops = 0;
+
+    bool audible = false;
+    bool noisy = false;                     // Last window crossed zero too often to be voiced
+    bool open = false;
+    int unvoicedHops = 0;                   // Consecutive hops that wanted the gate closed
+    PitchEstimate lastVoiced;               // Stands in for the hops the gate is held open through
+};
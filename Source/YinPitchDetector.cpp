@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    YinPitchDetector.cpp
+
+  ==============================================================================
+*/
+
+#include "YinPitchDetector.h"
+
+void YinPitchDetector::prepare(double newSampleRate, int newWindowSize, float minFrequency, float maxFrequency)
+{
+    sampleRate = newSampleRate;
+    windowSize = newWindowSize;
+    prepareLags(sampleRate, windowSize, minFrequency, maxFrequency);
+
+    autocorrelator.prepare(windowSize);
+    autocorr.assign(static_cast<size_t>(windowSize), 0.0f);
+    energy.assign(static_cast<size_t>(windowSize + 1), 0.0f);
+    cmndf.assign(static_cast<size_t>(lags.getEnd() + 1), 1.0f);
+}
+
+PitchEstimate YinPitchDetector::detect(const float* window) noexcept
+{
+    autocorrelator.process(window, windowSize, autocorr.data());
+
+    energy[0] = 0.0f;
+    for (int i = 0; i < windowSize; ++i)
+        energy[(size_t)i + 1] = energy[(size_t)i] + window[i] * window[i];
+
+    if (energy[(size_t)windowSize] <= 0.0f)
+        return {};
+
+    // d(tau) = sum over the overlap of (x[i] - x[i + tau])^2, expanded into energies and r(tau),
+    // then normalized by its running mean so d'(0) = 1 and the threshold is level-independent
+    const int maxLag = lags.getEnd();
+    const float total = energy[(size_t)windowSize];
+    float runningSum = 0.0f;
+    cmndf[0] = 1.0f;
+    for (int tau = 1; tau <= maxLag; ++tau)
+    {
+        const float difference = juce::jmax(0.0f, energy[(size_t)(windowSize - tau)] + total - energy[(size_t)tau]
+                                                      - 2.0f * autocorr[(size_t)tau]);
+        runningSum += difference;
+        cmndf[(size_t)tau] = runningSum > 0.0f ? difference * tau / runningSum : 1.0f;
+    }
+
+    // First dip below the threshold, followed down to its local minimum
+    int bestLag = 0;
+    for (int tau = lags.getStart(); tau < maxLag; ++tau)
+    {
+        if (cmndf[(size_t)tau] < threshold)
+        {
+            while (tau + 1 < maxLag && cmndf[(size_t)tau + 1] < cmndf[(size_t)tau])
+                ++tau;
+            bestLag = tau;
+            break;
+        }
+    }
+
+    // No dip under the threshold: fall back to the global minimum, reported with low confidence
+    if (bestLag == 0)
+    {
+        bestLag = lags.getStart();
+        for (int tau = lags.getStart() + 1; tau < maxLag; ++tau)
+            if (cmndf[(size_t)tau] < cmndf[(size_t)bestLag])
+                bestLag = tau;
+    }
+
+    if (bestLag <= 1 || bestLag >= maxLag)
+        return {};
+
+    const float period = bestLag + parabolicOffset(cmndf[(size_t)bestLag - 1], cmndf[(size_t)bestLag], cmndf[(size_t)bestLag + 1]);
+    return { static_cast<float>(sampleRate / period), juce::jlimit(0.0f, 1.0f, 1.0f - cmndf[(size_t)bestLag]) };
+}
@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    YinPitchDetector.h
+
+    YIN (de Cheveigne & Kawahara, 2002): cumulative mean normalized difference
+    function with an absolute threshold.  The difference function is derived
+    from an FFT autocorrelation so the cost is O(N log N) per window.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PitchDetector.h"
+#include "FFTAutocorrelator.h"
+
+class YinPitchDetector : public PitchDetector
+{
+public:
+    void prepare(double sampleRate, int windowSize, float minFrequency, float maxFrequency) override;
+    PitchEstimate detect(const float* window) noexcept override;
+    const char* getName() const noexcept override { return "YIN"; }
+
+private:
+    static constexpr float threshold = 0.15f;  // Absolute CMNDF threshold from the paper
+
+    FFTAutocorrelator autocorrelator;
+    std::vector<float> autocorr;
+    std::vector<float> energy;                  // energy[k] = sum of x[i]^2 for i < k
+    std::vector<float> cmndf;
+    double sampleRate = 44100.0;
+    int windowSize = 0;
+};
@@ -0,0 +1,384 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    BatchRender: runs AutotuneAudioProcessor offline over a folder of audio
+    files.  Each worker thread owns one processor and pulls files from a
+    shared index, writing a corrected WAV and a per-hop pitch CSV per file.
+    Needs no audio device or display, so it runs on headless build machines.
+    With --pitch-maps, each file's pitch contour is analysed once into a
+    cache folder and read back on every later render instead of detected.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+struct RenderOptions
+{
+    juce::File inputFolder;
+    juce::File outputFolder;
+    int blockSize = 512;
+    int numThreads = 1;
+    ProcessingMode mode = ProcessingMode::psola;
+    PitchDetectorType detector = PitchDetectorType::autocorrelation;
+    InterpolationQuality interpolation = InterpolationQuality::high;
+    FormantMode formants = FormantMode::off;
+    bool lookahead = false;
+    juce::File pitchMapFolder;              // PitchMap cache; none when empty
+};
+
+//==============================================================================
+// Tells the processor where in the file each block is, so it can index a PitchMap
+class RenderPlayHead : public juce::AudioPlayHead
+{
+public:
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setTimeInSamples(position);
+        info.setIsPlaying(true);
+        return info;
+    }
+
+    juce::int64 position = 0;
+};
+
+//==============================================================================
+class RenderWorker : public juce::Thread
+{
+public:
+    RenderWorker(const RenderOptions& o, const juce::Array<juce::File>& f, std::atomic<int>& next, juce::CriticalSection& consoleLock)
+        : juce::Thread("Render worker"), options(o), files(f), nextFile(next), printLock(consoleLock)
+    {
+        formats.registerBasicFormats();
+        processor.setNonRealtime(true);
+        processor.setProcessingMode(options.mode);
+        processor.setPitchDetectorType(options.detector);
+        processor.setInterpolationQuality(options.interpolation);
+        processor.setFormantMode(options.formants);
+        processor.setLookaheadEnabled(options.lookahead);
+        processor.setPlayHead(&playHead);
+    }
+
+    void run() override
+    {
+        for (int index = nextFile++; index < files.size() && !threadShouldExit(); index = nextFile++)
+        {
+            if (!render(files[index]))
+                ++numFailed;
+        }
+    }
+
+    double audioSeconds = 0.0;              // Total duration rendered by this worker
+    int numFailed = 0;
+
+private:
+    void print(const juce::String& message)
+    {
+        const juce::ScopedLock sl(printLock);
+        std::cout << message << std::endl;
+    }
+
+    bool render(const juce::File& file)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+        if (reader == nullptr)
+        {
+            print(file.getFileName() + ": unreadable, skipped");
+            return false;
+        }
+
+        const int numChannels = (int)reader->numChannels;
+        const double sampleRate = reader->sampleRate;
+        if (numChannels < 1 || numChannels > AutotuneAudioProcessor::maxChannels)
+        {
+            print(file.getFileName() + ": " + juce::String(numChannels) + " channels not supported, skipped");
+            return false;
+        }
+
+        const auto outputFile = options.outputFolder.getChildFile(file.getFileNameWithoutExtension() + ".wav");
+        const auto csvFile = options.outputFolder.getChildFile(file.getFileNameWithoutExtension() + "_pitch.csv");
+        outputFile.deleteFile();
+        csvFile.deleteFile();
+
+        juce::WavAudioFormat wav;
+        const int bitsPerSample = wav.getPossibleBitDepths().contains((int)reader->bitsPerSample) ? (int)reader->bitsPerSample : 24;
+        std::unique_ptr<juce::OutputStream> stream(outputFile.createOutputStream());
+        std::unique_ptr<juce::AudioFormatWriter> writer(stream != nullptr ? wav.createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels, bitsPerSample, {}, 0)
+                                                                          : nullptr);
+        if (writer == nullptr)
+        {
+            print(file.getFileName() + ": can't write " + outputFile.getFullPathName());
+            return false;
+        }
+        stream.release(); // Now owned by the writer
+
+        juce::FileOutputStream csv(csvFile);
+        if (csv.failedToOpen())
+        {
+            print(file.getFileName() + ": can't write " + csvFile.getFullPathName());
+            return false;
+        }
+        csv << "time_seconds,detected_hz,target_note,ratio,confidence" << juce::newLine;
+
+        // Each file is rendered from sample 0 of the play head's timeline
+        if (options.pitchMapFolder != juce::File())
+            processor.setPitchMap(loadPitchMap(file, *reader), 0);
+
+        // Rendered in the file's own layout, so mono takes only process one channel
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, options.blockSize);
+        processor.prepareToPlay(sampleRate, options.blockSize);
+        processor.getTelemetry().drain([](const PitchTelemetryRecord&) {});
+
+        juce::AudioBuffer<float> buffer(numChannels, options.blockSize);
+        juce::MidiBuffer midi;
+        const double startTime = juce::Time::getMillisecondCounterHiRes();
+
+        // The processor's latency is trimmed from the start of the output and flushed out
+        // with silence at the end, so the render lines up with its source
+        const int latencySamples = processor.getLatencySamples();
+        const juce::int64 totalSamples = reader->lengthInSamples + latencySamples;
+
+        for (juce::int64 position = 0; position < totalSamples; position += options.blockSize)
+        {
+            const int numSamples = (int)juce::jmin((juce::int64)options.blockSize, totalSamples - position);
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+
+            // Past the end of the file the reader fills with silence
+            reader->read(&block, 0, numSamples, position, true, true);
+            playHead.position = position;
+            processor.processBlock(block, midi);
+            midi.clear();
+
+            const int skip = (int)juce::jlimit((juce::int64)0, (juce::int64)numSamples, latencySamples - position);
+            writer->writeFromAudioSampleBuffer(block, skip, numSamples - skip);
+
+            processor.getTelemetry().drain([&](const PitchTelemetryRecord& record)
+            {
+                csv << juce::String((double)record.samplePosition / sampleRate, 4) << ","
+                    << juce::String(record.detectedFrequency, 2) << ","
+                    << juce::String(record.targetNote, 0) << ","
+                    << juce::String(record.ratio, 5) << ","
+                    << juce::String(record.confidence, 3) << juce::newLine;
+            });
+        }
+
+        processor.releaseResources();
+        processor.setPitchMap(nullptr);
+
+        const double seconds = (double)reader->lengthInSamples / sampleRate;
+        const double elapsed = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        audioSeconds += seconds;
+
+        print(file.getFileName() + ": " + juce::String(seconds, 1) + " s in " + juce::String(elapsed, 2) + " s ("
+              + juce::String(seconds / juce::jmax(elapsed, 1.0e-6), 1) + "x realtime)");
+        return true;
+    }
+
+    // The cached map of the file's audio, analysed first if there isn't one yet or it was
+    // analysed with other settings
+    std::unique_ptr<PitchMap> loadPitchMap(const juce::File& file, juce::AudioFormatReader& reader)
+    {
+        const auto settings = processor.getPitchMapSettings();
+        const auto contentHash = PitchMap::hashAudio(reader);
+        if (!contentHash.hasValue())
+        {
+            print(file.getFileName() + ": can't read the audio to find its pitch map, detecting in real time");
+            return {};
+        }
+
+        const auto mapFile = PitchMap::getCacheFile(options.pitchMapFolder, *contentHash);
+        if (auto map = PitchMap::open(mapFile, settings))
+            return map;
+
+        if (!PitchMap::analyse(reader, settings, *contentHash, mapFile))
+        {
+            print(file.getFileName() + ": can't write " + mapFile.getFullPathName() + ", detecting in real time");
+            return {};
+        }
+
+        print(file.getFileName() + ": analysed into " + mapFile.getFileName());
+        return PitchMap::open(mapFile, settings);
+    }
+
+    const RenderOptions& options;
+    const juce::Array<juce::File>& files;
+    std::atomic<int>& nextFile;
+    juce::CriticalSection& printLock;
+    juce::AudioFormatManager formats;
+    RenderPlayHead playHead;
+    AutotuneAudioProcessor processor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderWorker)
+};
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: BatchRender <input folder> <output folder> [options]" << std::endl
+              << "  --threads N        Worker threads (default: one per CPU)" << std::endl
+              << "  --block N          Processing block size in samples (default 512)" << std::endl
+              << "  --mode M           psola or vocoder (default psola)" << std::endl
+              << "  --detector D       autocorrelation, yin or mcleod (default autocorrelation)" << std::endl
+              << "  --interpolation Q  draft, normal or high (default high)" << std::endl
+              << "  --formants F       Vocoder formant preservation: off, fast or high (default off)" << std::endl
+              << "  --lookahead        Detect ahead of the audio so corrections land on note onsets" << std::endl
+              << "  --pitch-maps DIR   Cache of analysed pitch contours to read instead of detecting" << std::endl;
+}
+
+static bool parseOptions(const juce::ArgumentList& args, RenderOptions& options)
+{
+    if (args.size() < 2 || args.containsOption("--help|-h"))
+        return false;
+
+    options.inputFolder = args[0].resolveAsFile();
+    options.outputFolder = args[1].resolveAsFile();
+    options.numThreads = juce::SystemStats::getNumCpus();
+
+    if (args.containsOption("--threads"))
+        options.numThreads = args.getValueForOption("--threads").getIntValue();
+    if (args.containsOption("--block"))
+        options.blockSize = args.getValueForOption("--block").getIntValue();
+
+    if (args.containsOption("--mode"))
+    {
+        const auto mode = args.getValueForOption("--mode");
+        if (mode.equalsIgnoreCase("psola"))
+            options.mode = ProcessingMode::psola;
+        else if (mode.equalsIgnoreCase("vocoder"))
+            options.mode = ProcessingMode::phaseVocoder;
+        else
+            return false;
+    }
+
+    if (args.containsOption("--detector"))
+    {
+        const auto name = args.getValueForOption("--detector");
+        int type = 0;
+        while (type < (int)PitchDetectorType::numTypes && !name.equalsIgnoreCase(PitchDetector::create((PitchDetectorType)type)->getName()))
+            ++type;
+
+        if (type == (int)PitchDetectorType::numTypes)
+            return false;
+
+        options.detector = (PitchDetectorType)type;
+    }
+
+    options.lookahead = args.containsOption("--lookahead");
+    if (args.containsOption("--pitch-maps"))
+        options.pitchMapFolder = args.getFileForOption("--pitch-maps");
+
+    if (args.containsOption("--interpolation"))
+    {
+        const auto quality = args.getValueForOption("--interpolation");
+        if (quality.equalsIgnoreCase("draft"))
+            options.interpolation = InterpolationQuality::draft;
+        else if (quality.equalsIgnoreCase("normal"))
+            options.interpolation = InterpolationQuality::normal;
+        else if (quality.equalsIgnoreCase("high"))
+            options.interpolation = InterpolationQuality::high;
+        else
+            return false;
+    }
+
+    if (args.containsOption("--formants"))
+    {
+        const auto formants = args.getValueForOption("--formants");
+        if (formants.equalsIgnoreCase("off"))
+            options.formants = FormantMode::off;
+        else if (formants.equalsIgnoreCase("fast"))
+            options.formants = FormantMode::fast;
+        else if (formants.equalsIgnoreCase("high"))
+            options.formants = FormantMode::high;
+        else
+            return false;
+    }
+
+    return options.numThreads > 0 && options.blockSize > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // The processor's parameter state starts a timer, which needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    RenderOptions options;
+    if (!parseOptions(juce::ArgumentList(argc, argv), options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (!options.inputFolder.isDirectory() || !options.outputFolder.createDirectory())
+    {
+        std::cout << "Input folder must exist and output folder must be creatable" << std::endl;
+        return 1;
+    }
+
+    // Renders are named after their sources, so in the input folder they would replace them
+    if (options.outputFolder.getLinkedTarget() == options.inputFolder.getLinkedTarget())
+    {
+        std::cout << "Output folder must differ from the input folder" << std::endl;
+        return 1;
+    }
+
+    if (options.pitchMapFolder != juce::File() && !options.pitchMapFolder.createDirectory())
+    {
+        std::cout << "Pitch map folder must be creatable" << std::endl;
+        return 1;
+    }
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    const auto files = options.inputFolder.findChildFiles(juce::File::findFiles, false, formats.getWildcardForAllFormats());
+    if (files.isEmpty())
+    {
+        std::cout << "No audio files in " << options.inputFolder.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // Outputs drop the source's extension, so take.aif and take.wav would both render to
+    // take.wav, from two workers at once; ignoring case, for case-insensitive file systems
+    juce::StringArray outputNames;
+    for (auto& file : files)
+    {
+        const auto name = file.getFileNameWithoutExtension();
+        const int existing = outputNames.indexOf(name, true);
+        if (existing >= 0)
+        {
+            std::cout << files[existing].getFileName() << " and " << file.getFileName()
+                      << " would render to the same output; rename one of them" << std::endl;
+            return 1;
+        }
+        outputNames.add(name);
+    }
+
+    std::atomic<int> nextFile { 0 };
+    juce::CriticalSection printLock;
+    juce::OwnedArray<RenderWorker> workers;
+    for (int i = 0; i < juce::jmin(options.numThreads, files.size()); ++i)
+        workers.add(new RenderWorker(options, files, nextFile, printLock));
+
+    const double startTime = juce::Time::getMillisecondCounterHiRes();
+    for (auto* worker : workers)
+        worker->startThread();
+
+    double audioSeconds = 0.0;
+    int numFailed = 0;
+    for (auto* worker : workers)
+    {
+        worker->waitForThreadToExit(-1);
+        audioSeconds += worker->audioSeconds;
+        numFailed += worker->numFailed;
+    }
+
+    const double elapsed = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    std::cout << files.size() - numFailed << " of " << files.size() << " files, " << juce::String(audioSeconds, 1)
+              << " s of audio in " << juce::String(elapsed, 2) << " s on " << workers.size() << " threads ("
+              << juce::String(audioSeconds / juce::jmax(elapsed, 1.0e-6), 1) << "x realtime)" << std::endl;
+
+    return numFailed == 0 ? 0 : 2;
+}
@@ -0,0 +1,336 @@
+/*
+  ==============================================================================
+
+    AccuracyBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "AccuracyBenchmark.h"
+#include "../../../Source/PluginProcessor.h"
+
+namespace AccuracyBenchmark
+{
+    struct ReferenceSignal
+    {
+        const char* name;
+        std::vector<float> frequency;       // Instantaneous Hz per sample, 0 where silent
+        std::vector<int> events;            // Samples where a held pitch jumps, starts or stops
+        bool heldNotes = false;             // Notes last long enough to check the snapped target
+    };
+
+    struct Metrics
+    {
+        int numFrames = 0;                  // Frames on voiced input whose window holds no event
+        double meanCents = 0.0;             // Mean absolute error, octave errors excluded
+        double p95Cents = 0.0;
+        double octaveErrorPercent = 0.0;    // Frames more than half an octave out
+        double unvoicedPercent = 0.0;       // Frames reported unvoiced on voiced input
+        int latencySamples = 0;             // Worst delay from a note start or jump to the first frame within 50 cents
+        int targetErrors = 0;               // Settled held-note frames snapped to the wrong scale note
+        double ratioErrorCents = 0.0;       // Worst distance of the corrected pitch from the target on settled frames
+    };
+
+    //==============================================================================
+    static void appendNote(ReferenceSignal& signal, double sampleRate, float frequency, double seconds)
+    {
+        if (signal.frequency.empty() ? frequency > 0.0f : signal.frequency.back() != frequency)
+            signal.events.push_back((int)signal.frequency.size());
+
+        signal.frequency.insert(signal.frequency.end(), (size_t)(seconds * sampleRate), frequency);
+    }
+
+    static std::vector<ReferenceSignal> createSignals(double sampleRate)
+    {
+        std::vector<ReferenceSignal> signals;
+
+        // In-scale notes across the detector range, plus off-scale ones that must snap
+        // (150 Hz -> D3, 240 Hz -> B3, 430 Hz -> A4)
+        ReferenceSignal steady { "steady" };
+        steady.heldNotes = true;
+        for (float frequency : { 82.41f, 110.0f, 150.0f, 196.0f, 240.0f, 261.63f, 430.0f, 523.25f, 659.25f, 880.0f })
+            appendNote(steady, sampleRate, frequency, 0.6);
+        signals.push_back(std::move(steady));
+
+        ReferenceSignal octaves { "octaves" };
+        octaves.heldNotes = true;
+        for (float frequency : { 220.0f, 440.0f, 220.0f, 440.0f, 110.0f, 220.0f })
+            appendNote(octaves, sampleRate, frequency, 0.6);
+        signals.push_back(std::move(octaves));
+
+        ReferenceSignal onsets { "onsets" };
+        onsets.heldNotes = true;
+        for (float frequency : { 0.0f, 196.0f, 0.0f, 330.0f, 0.0f, 98.0f })
+            appendNote(onsets, sampleRate, frequency, frequency > 0.0f ? 0.8 : 0.4);
+        signals.push_back(std::move(onsets));
+
+        // Two octaves up over two seconds
+        ReferenceSignal glide { "glide" };
+        appendNote(glide, sampleRate, 110.0f, 0.3);
+        const int glideLength = (int)(2.0 * sampleRate);
+        for (int i = 0; i < glideLength; ++i)
+            glide.frequency.push_back(110.0f * std::pow(4.0f, (float)i / glideLength));
+        glide.frequency.insert(glide.frequency.end(), (size_t)(0.3 * sampleRate), 440.0f);
+        signals.push_back(std::move(glide));
+
+        // +-50 cents at 5.5 Hz around A3
+        ReferenceSignal vibrato { "vibrato" };
+        appendNote(vibrato, sampleRate, 220.0f, 0.3);
+        const int vibratoLength = (int)(2.0 * sampleRate);
+        for (int i = 0; i < vibratoLength; ++i)
+            vibrato.frequency.push_back(220.0f * std::pow(2.0f, 0.5f / 12.0f * std::sin(juce::MathConstants<float>::twoPi * 5.5f * (float)i / (float)sampleRate)));
+        signals.push_back(std::move(vibrato));
+
+        return signals;
+    }
+
+    // Five harmonics at 1/k, so octave errors are as tempting as they are on a voice
+    static void synthesise(const ReferenceSignal& signal, double sampleRate, juce::AudioBuffer<float>& buffer)
+    {
+        buffer.setSize(2, (int)signal.frequency.size());
+        auto* output = buffer.getWritePointer(0);
+        double phase = 0.0;
+
+        for (size_t i = 0; i < signal.frequency.size(); ++i)
+        {
+            float sample = 0.0f;
+            if (signal.frequency[i] > 0.0f)
+            {
+                for (int k = 1; k <= 5; ++k)
+                    sample += (float)std::sin(phase * k) / (float)k;
+                phase += juce::MathConstants<double>::twoPi * signal.frequency[i] / sampleRate;
+            }
+            else
+            {
+                phase = 0.0;
+            }
+
+            output[i] = 0.3f * sample;
+        }
+
+        buffer.copyFrom(1, 0, buffer, 0, 0, buffer.getNumSamples());
+    }
+
+    // Reference for the processor's default key and scale: the nearest C major note
+    static int nearestCMajorNote(double midiNote)
+    {
+        static constexpr bool inScale[12] = { true, false, true, false, true, true, false, true, false, true, false, true };
+        int nearest = 0;
+        double nearestDistance = 1.0e9;
+
+        for (int note = (int)std::floor(midiNote) - 2; note <= (int)std::ceil(midiNote) + 2; ++note)
+        {
+            if (inScale[((note % 12) + 12) % 12] && std::abs(note - midiNote) < nearestDistance)
+            {
+                nearest = note;
+                nearestDistance = std::abs(note - midiNote);
+            }
+        }
+
+        return nearest;
+    }
+
+    static double centsBetween(double frequency, double reference)
+    {
+        return 1200.0 * std::log2(frequency / reference);
+    }
+
+    //==============================================================================
+    static Metrics measure(AutotuneAudioProcessor& processor, PitchDetectorType detector, double sampleRate, const ReferenceSignal& signal)
+    {
+        constexpr int blockSize = 512;
+
+        juce::AudioBuffer<float> input;
+        synthesise(signal, sampleRate, input);
+
+        processor.setProcessingMode(ProcessingMode::psola);
+        processor.setPitchDetectorType(detector);
+        processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+        processor.getTelemetry().drain([](const PitchTelemetryRecord&) {});
+
+        std::vector<PitchTelemetryRecord> records;
+        juce::AudioBuffer<float> block(2, blockSize);
+        juce::MidiBuffer midi;
+
+        for (int position = 0; position < input.getNumSamples(); position += blockSize)
+        {
+            const int numSamples = juce::jmin(blockSize, input.getNumSamples() - position);
+            juce::AudioBuffer<float> view(block.getArrayOfWritePointers(), 2, numSamples);
+            for (int ch = 0; ch < 2; ++ch)
+                view.copyFrom(ch, 0, input, ch, position, numSamples);
+
+            processor.processBlock(view, midi);
+            midi.clear();
+            processor.getTelemetry().drain([&](const PitchTelemetryRecord& record) { records.push_back(record); });
+        }
+
+        // Each record describes the window that ended at its sample position; the one the
+        // processor was prepared with, not the configured seconds
+        const int windowSize = processor.getAnalysisWindowSamples();
+        processor.releaseResources();
+
+        const int settleSamples = (int)(0.35 * sampleRate);
+        const auto& events = signal.events;
+
+        Metrics metrics;
+        std::vector<double> errors;
+        int numOctaveErrors = 0, numUnvoiced = 0;
+
+        for (auto& record : records)
+        {
+            const int end = (int)juce::jmin(record.samplePosition, (juce::int64)signal.frequency.size());
+            const int start = end - windowSize;
+            if (start < 0)
+                continue;
+
+            const auto nextEvent = std::upper_bound(events.begin(), events.end(), start);
+            if (nextEvent != events.end() && *nextEvent <= end)
+                continue;
+
+            const double reference = signal.frequency[(size_t)(end - windowSize / 2)];
+            if (reference <= 0.0)
+                continue;
+
+            ++metrics.numFrames;
+
+            if (record.detectedFrequency <= 0.0f)
+            {
+                ++numUnvoiced;
+                continue;
+            }
+
+            const double cents = centsBetween(record.detectedFrequency, reference);
+            if (std::abs(cents) > 600.0)
+                ++numOctaveErrors;
+            else
+                errors.push_back(std::abs(cents));
+
+            const int lastEvent = nextEvent == events.begin() ? 0 : *(nextEvent - 1);
+            if (signal.heldNotes && end - lastEvent >= settleSamples)
+            {
+                const int expectedNote = nearestCMajorNote(69.0 + 12.0 * std::log2(reference / 440.0));
+                if (juce::roundToInt(record.targetNote) != expectedNote)
+                {
+                    ++metrics.targetErrors;
+                }
+                else
+                {
+                    const double targetFrequency = 440.0 * std::pow(2.0, (expectedNote - 69) / 12.0);
+                    metrics.ratioErrorCents = juce::jmax(metrics.ratioErrorCents, std::abs(centsBetween(reference * record.ratio, targetFrequency)));
+                }
+            }
+        }
+
+        if (!errors.empty())
+        {
+            std::sort(errors.begin(), errors.end());
+            metrics.meanCents = std::accumulate(errors.begin(), errors.end(), 0.0) / (double)errors.size();
+            metrics.p95Cents = errors[(size_t)(0.95 * (double)(errors.size() - 1))];
+        }
+
+        if (metrics.numFrames > 0)
+        {
+            metrics.octaveErrorPercent = 100.0 * numOctaveErrors / metrics.numFrames;
+            metrics.unvoicedPercent = 100.0 * numUnvoiced / metrics.numFrames;
+        }
+
+        // An event that is never tracked before the next one counts as the whole span
+        for (size_t e = 0; e < events.size(); ++e)
+        {
+            const float frequency = signal.frequency[(size_t)events[e]];
+            if (frequency <= 0.0f)
+                continue;
+
+            const int limit = e + 1 < events.size() ? events[e + 1] : (int)signal.frequency.size();
+            int latency = limit - events[e];
+
+            for (auto& record : records)
+            {
+                if (record.samplePosition > events[e] && record.samplePosition <= limit && record.detectedFrequency > 0.0f
+                    && std::abs(centsBetween(record.detectedFrequency, frequency)) < 50.0)
+                {
+                    latency = (int)record.samplePosition - events[e];
+                    break;
+                }
+            }
+
+            metrics.latencySamples = juce::jmax(metrics.latencySamples, latency);
+        }
+
+        return metrics;
+    }
+
+    //==============================================================================
+    struct Thresholds
+    {
+        double meanCents, p95Cents, octaveErrorPercent, unvoicedPercent, latencyMs, targetErrors, ratioErrorCents;
+    };
+
+    // detector,signal,max_mean_cents,max_p95_cents,max_octave_error_percent,max_unvoiced_percent,max_latency_ms,max_target_errors,max_ratio_error_cents
+    static std::map<juce::String, Thresholds> loadThresholds(const juce::File& file)
+    {
+        std::map<juce::String, Thresholds> thresholds;
+        juce::StringArray lines;
+        file.readLines(lines);
+
+        for (auto& line : lines)
+        {
+            juce::StringArray fields;
+            fields.addTokens(line, ",", {});
+            if (fields.size() != 9 || fields[0] == "detector")
+                continue;
+
+            thresholds[fields[0].toLowerCase() + "," + fields[1]] = { fields[2].getDoubleValue(), fields[3].getDoubleValue(), fields[4].getDoubleValue(),
+                                                                      fields[5].getDoubleValue(), fields[6].getDoubleValue(), fields[7].getDoubleValue(),
+                                                                      fields[8].getDoubleValue() };
+        }
+
+        return thresholds;
+    }
+
+    int run(const juce::StringArray& sampleRates, const juce::File& thresholdsFile)
+    {
+        const auto thresholds = loadThresholds(thresholdsFile);
+        AutotuneAudioProcessor processor;
+        int numViolations = 0;
+
+        std::cout << "detector,sample_rate,signal,frames,mean_cents,p95_cents,octave_error_percent,unvoiced_percent,latency_samples,target_errors,ratio_error_cents" << std::endl;
+
+        for (int type = 0; type < (int)PitchDetectorType::numTypes; ++type)
+        {
+            const auto detectorName = juce::String(processor.getPitchDetectorName((PitchDetectorType)type)).toLowerCase();
+
+            for (auto& rate : sampleRates)
+            {
+                const double sampleRate = rate.getDoubleValue();
+
+                for (auto& signal : createSignals(sampleRate))
+                {
+                    const auto m = measure(processor, (PitchDetectorType)type, sampleRate, signal);
+                    const double latencyMs = 1000.0 * m.latencySamples / sampleRate;
+
+                    std::cout << detectorName << "," << rate << "," << signal.name << "," << m.numFrames << ","
+                              << juce::String(m.meanCents, 2) << "," << juce::String(m.p95Cents, 2) << ","
+                              << juce::String(m.octaveErrorPercent, 2) << "," << juce::String(m.unvoicedPercent, 2) << ","
+                              << m.latencySamples << "," << m.targetErrors << "," << juce::String(m.ratioErrorCents, 2) << std::endl;
+
+                    const auto found = thresholds.find(detectorName + "," + signal.name);
+                    if (found == thresholds.end())
+                        continue;
+
+                    const auto& limit = found->second;
+                    if (m.meanCents > limit.meanCents || m.p95Cents > limit.p95Cents || m.octaveErrorPercent > limit.octaveErrorPercent
+                        || m.unvoicedPercent > limit.unvoicedPercent || latencyMs > limit.latencyMs
+                        || m.targetErrors > limit.targetErrors || m.ratioErrorCents > limit.ratioErrorCents)
+                    {
+                        std::cerr << "FAIL " << detectorName << " " << rate << " Hz " << signal.name << " exceeds its thresholds" << std::endl;
+                        ++numViolations;
+                    }
+                }
+            }
+        }
+
+        return numViolations;
+    }
+}
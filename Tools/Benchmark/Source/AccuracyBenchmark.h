@@ -0,0 +1,25 @@
+/*
+  ==============================================================================
+
+    AccuracyBenchmark.h
+
+    Pitch-tracking conformance: drives the processor with signals whose
+    instantaneous frequency is known and compares its telemetry against it.
+    Reports cents error, octave-error rate and detection latency for each
+    detector and sample rate, and checks the default C major snap and ratio on held
+    notes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace AccuracyBenchmark
+{
+    /** Prints one CSV row per detector, sample rate and signal.  If thresholdsFile
+        exists, every row is checked against it; returns the number of violations.
+    */
+    int run(const juce::StringArray& sampleRates, const juce::File& thresholdsFile);
+}
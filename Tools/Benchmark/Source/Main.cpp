@@ -0,0 +1,302 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Benchmark: times AutotuneAudioProcessor::processBlock on synthetic input
+    across sample rates, block sizes, processing modes, PSOLA
+    interpolation tiers and formant modes.  Results go to
+    stdout as CSV, one row per configuration, and can be checked against a
+    previous run with --baseline to catch regressions.  --accuracy measures
+    pitch tracking instead (see AccuracyBenchmark).
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "TestSignals.h"
+#include "AccuracyBenchmark.h"
+
+//==============================================================================
+// Counts heap allocations made by the thread that is inside processBlock, through every
+// replaceable form of operator new: plain, nothrow and over-aligned, single and array
+static std::atomic<juce::int64> numAllocations { 0 };
+static thread_local bool countAllocations = false;
+
+static void* allocate(std::size_t size, std::size_t alignment) noexcept
+{
+    if (countAllocations)
+        numAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    size = size > 0 ? size : 1;
+    if (alignment == 0)
+        return std::malloc(size);
+
+   #if JUCE_WINDOWS
+    return _aligned_malloc(size, alignment);
+   #else
+    void* p = nullptr;
+    return posix_memalign(&p, juce::jmax(alignment, sizeof(void*)), size) == 0 ? p : nullptr;
+   #endif
+}
+
+static void deallocate(void* p, std::size_t alignment) noexcept
+{
+   #if JUCE_WINDOWS
+    if (alignment != 0)
+    {
+        _aligned_free(p);
+        return;
+    }
+   #else
+    juce::ignoreUnused(alignment);
+   #endif
+
+    std::free(p);
+}
+
+static void* allocateOrThrow(std::size_t size, std::size_t alignment)
+{
+    if (void* p = allocate(size, alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size)                                              { return allocateOrThrow(size, 0); }
+void* operator new[](std::size_t size)                                            { return allocateOrThrow(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept              { return allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept            { return allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t a)                          { return allocateOrThrow(size, (std::size_t)a); }
+void* operator new[](std::size_t size, std::align_val_t a)                        { return allocateOrThrow(size, (std::size_t)a); }
+void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept   { return allocate(size, (std::size_t)a); }
+void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return allocate(size, (std::size_t)a); }
+
+void operator delete(void* p) noexcept                                            { deallocate(p, 0); }
+void operator delete[](void* p) noexcept                                          { deallocate(p, 0); }
+void operator delete(void* p, std::size_t) noexcept                               { deallocate(p, 0); }
+void operator delete[](void* p, std::size_t) noexcept                             { deallocate(p, 0); }
+void operator delete(void* p, const std::nothrow_t&) noexcept                     { deallocate(p, 0); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept                   { deallocate(p, 0); }
+void operator delete(void* p, std::align_val_t a) noexcept                        { deallocate(p, (std::size_t)a); }
+void operator delete[](void* p, std::align_val_t a) noexcept                      { deallocate(p, (std::size_t)a); }
+void operator delete(void* p, std::size_t, std::align_val_t a) noexcept           { deallocate(p, (std::size_t)a); }
+void operator delete[](void* p, std::size_t, std::align_val_t a) noexcept         { deallocate(p, (std::size_t)a); }
+void operator delete(void* p, std::align_val_t a, const std::nothrow_t&) noexcept   { deallocate(p, (std::size_t)a); }
+void operator delete[](void* p, std::align_val_t a, const std::nothrow_t&) noexcept { deallocate(p, (std::size_t)a); }
+
+//==============================================================================
+struct BenchmarkResult
+{
+    juce::String key;                       // engine,signal,rate,block
+    double nsPerSample = 0.0;
+    double worstBlockPercent = 0.0;         // Slowest block as a share of its real-time deadline
+    double allocationsPerBlock = 0.0;
+
+    juce::String toCsv() const
+    {
+        return key + "," + juce::String(nsPerSample, 2) + "," + juce::String(worstBlockPercent, 2) + "," + juce::String(allocationsPerBlock, 3);
+    }
+};
+
+// One row per PSOLA interpolation tier, so the cost of each tier is tracked; the vocoder doesn't
+// interpolate.  The harmony row renders four voices, to compare with four psola-normal instances;
+// the formant rows price each envelope tier against the plain vocoder row, and the mono rows
+// a mono track against the same engine in stereo.
+struct EngineConfiguration
+{
+    const char* name;
+    ProcessingMode mode;
+    InterpolationQuality interpolation;
+    int harmonyVoices;
+    FormantMode formants;
+    int numChannels;
+};
+
+static constexpr EngineConfiguration engineConfigurations[] = {
+    { "psola-draft",      ProcessingMode::psola,        InterpolationQuality::draft,  0, FormantMode::off,  2 },
+    { "psola-normal",     ProcessingMode::psola,        InterpolationQuality::normal, 0, FormantMode::off,  2 },
+    { "psola-high",       ProcessingMode::psola,        InterpolationQuality::high,   0, FormantMode::off,  2 },
+    { "psola-harmony3",   ProcessingMode::psola,        InterpolationQuality::normal, 3, FormantMode::off,  2 },
+    { "psola-mono",       ProcessingMode::psola,        InterpolationQuality::normal, 0, FormantMode::off,  1 },
+    { "vocoder",          ProcessingMode::phaseVocoder, InterpolationQuality::normal, 0, FormantMode::off,  2 },
+    { "vocoder-fmt-fast", ProcessingMode::phaseVocoder, InterpolationQuality::normal, 0, FormantMode::fast, 2 },
+    { "vocoder-fmt-high", ProcessingMode::phaseVocoder, InterpolationQuality::normal, 0, FormantMode::high, 2 },
+    { "vocoder-mono",     ProcessingMode::phaseVocoder, InterpolationQuality::normal, 0, FormantMode::off,  1 },
+};
+
+static BenchmarkResult runBenchmark(AutotuneAudioProcessor& processor, const EngineConfiguration& engine, TestSignals::Type signal,
+                                    double sampleRate, int blockSize, double seconds)
+{
+    const int warmupSamples = (int)(0.25 * sampleRate);
+    const int numSamples = warmupSamples + (int)(seconds * sampleRate);
+
+    const int numChannels = engine.numChannels;
+    juce::AudioBuffer<float> input(numChannels, numSamples);
+    TestSignals::generate(signal, sampleRate, input);
+
+    processor.setProcessingMode(engine.mode);
+    processor.setInterpolationQuality(engine.interpolation);
+    processor.setHarmonyVoices(engine.harmonyVoices);
+    processor.setFormantMode(engine.formants);
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::int64 totalTicks = 0, worstTicks = 0, measuredSamples = 0, measuredBlocks = 0;
+    numAllocations = 0;
+
+    for (int position = 0; position + blockSize <= numSamples; position += blockSize)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            block.copyFrom(ch, 0, input, ch, position, blockSize);
+
+        const bool measured = position >= warmupSamples;
+        const auto start = juce::Time::getHighResolutionTicks();
+        countAllocations = measured;
+        processor.processBlock(block, midi);
+        countAllocations = false;
+        const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+        // Keeps the telemetry queue from filling; the editor does this in the plugin
+        processor.getTelemetry().drain([](const PitchTelemetryRecord&) {});
+        midi.clear();
+
+        if (measured)
+        {
+            totalTicks += elapsed;
+            worstTicks = juce::jmax(worstTicks, elapsed);
+            measuredSamples += blockSize;
+            ++measuredBlocks;
+        }
+    }
+
+    processor.releaseResources();
+
+    BenchmarkResult result;
+    result.key = juce::String(engine.name) + "," + TestSignals::getName(signal) + "," + juce::String((int)sampleRate) + "," + juce::String(blockSize);
+    result.nsPerSample = juce::Time::highResolutionTicksToSeconds(totalTicks) * 1.0e9 / (double)juce::jmax((juce::int64)1, measuredSamples);
+    result.worstBlockPercent = 100.0 * juce::Time::highResolutionTicksToSeconds(worstTicks) / (blockSize / sampleRate);
+    result.allocationsPerBlock = (double)numAllocations.load() / (double)juce::jmax((juce::int64)1, measuredBlocks);
+    return result;
+}
+
+//==============================================================================
+// Returns the number of configurations that regressed against the baseline CSV
+static int compareWithBaseline(const juce::File& baselineFile, const juce::Array<BenchmarkResult>& results, double tolerance)
+{
+    juce::StringArray lines;
+    baselineFile.readLines(lines);
+
+    std::map<juce::String, BenchmarkResult> baseline;
+    for (auto& line : lines)
+    {
+        juce::StringArray fields;
+        fields.addTokens(line, ",", {});
+        if (fields.size() != 7 || fields[0] == "engine")
+            continue;
+
+        BenchmarkResult entry;
+        entry.key = fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3];
+        entry.nsPerSample = fields[4].getDoubleValue();
+        entry.worstBlockPercent = fields[5].getDoubleValue();
+        entry.allocationsPerBlock = fields[6].getDoubleValue();
+        baseline[entry.key] = entry;
+    }
+
+    int numRegressions = 0;
+    for (auto& result : results)
+    {
+        const auto found = baseline.find(result.key);
+        if (found == baseline.end())
+            continue;
+
+        const auto& previous = found->second;
+        const bool slower = result.nsPerSample > previous.nsPerSample * (1.0 + tolerance);
+        const bool allocates = result.allocationsPerBlock > previous.allocationsPerBlock;
+
+        if (slower || allocates)
+        {
+            std::cerr << "REGRESSION " << result.key << ": " << juce::String(previous.nsPerSample, 2) << " -> "
+                      << juce::String(result.nsPerSample, 2) << " ns/sample, " << juce::String(previous.allocationsPerBlock, 3)
+                      << " -> " << juce::String(result.allocationsPerBlock, 3) << " allocations/block" << std::endl;
+            ++numRegressions;
+        }
+    }
+
+    return numRegressions;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: Benchmark [options]" << std::endl
+              << "  --seconds S        Audio measured per configuration (default 2)" << std::endl
+              << "  --rates R,...      Sample rates (default 44100,48000,96000,192000)" << std::endl
+              << "  --blocks B,...     Block sizes (default 16,32,...,4096)" << std::endl
+              << "  --baseline FILE    Earlier output to compare against; exits non-zero on regression" << std::endl
+              << "  --tolerance T      Allowed ns/sample increase over the baseline (default 0.15)" << std::endl
+              << "  --accuracy         Measure pitch-tracking accuracy and latency instead of speed" << std::endl
+              << "  --thresholds FILE  Limits for --accuracy (AccuracyThresholds.csv); exits non-zero if exceeded" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    // The processor's parameter state starts a timer, which needs a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    const double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+    const double tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getDoubleValue() : 0.15;
+
+    juce::StringArray rates, blocks;
+    rates.addTokens(args.containsOption("--rates") ? args.getValueForOption("--rates") : juce::String("44100,48000,96000,192000"), ",", {});
+    blocks.addTokens(args.containsOption("--blocks") ? args.getValueForOption("--blocks") : juce::String("16,32,64,128,256,512,1024,2048,4096"), ",", {});
+
+    if (args.containsOption("--accuracy"))
+    {
+        const int numViolations = AccuracyBenchmark::run(rates, args.containsOption("--thresholds") ? args.getFileForOption("--thresholds") : juce::File());
+        if (numViolations > 0)
+        {
+            std::cerr << numViolations << " runs exceeded their accuracy thresholds" << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    AutotuneAudioProcessor processor;
+
+    juce::Array<BenchmarkResult> results;
+    std::cout << "engine,signal,sample_rate,block_size,ns_per_sample,worst_block_percent,allocations_per_block" << std::endl;
+
+    for (auto& engine : engineConfigurations)
+        for (int signal = 0; signal < (int)TestSignals::Type::numTypes; ++signal)
+            for (auto& rate : rates)
+                for (auto& blockSize : blocks)
+                {
+                    const auto result = runBenchmark(processor, engine, (TestSignals::Type)signal,
+                                                     rate.getDoubleValue(), blockSize.getIntValue(), seconds);
+                    std::cout << result.toCsv() << std::endl;
+                    results.add(result);
+                }
+
+    if (args.containsOption("--baseline"))
+    {
+        const int numRegressions = compareWithBaseline(args.getFileForOption("--baseline"), results, tolerance);
+        if (numRegressions > 0)
+        {
+            std::cerr << numRegressions << " configurations regressed" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    TestSignals.cpp
+
+  ==============================================================================
+*/
+
+#include "TestSignals.h"
+
+namespace TestSignals
+{
+    const char* getName(Type type)
+    {
+        switch (type)
+        {
+            case Type::sineSweep:       return "sweep";
+            case Type::formantPulses:   return "formants";
+            case Type::silence:         return "silence";
+            case Type::noise:           return "noise";
+            default:                    return "";
+        }
+    }
+
+    static void generateSweep(double sampleRate, float* output, int numSamples)
+    {
+        // 80 Hz to 1 kHz, phase accumulated so the sweep stays continuous
+        const double startFrequency = 80.0, endFrequency = 1000.0;
+        double phase = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double frequency = startFrequency * std::pow(endFrequency / startFrequency, (double)i / numSamples);
+            output[i] = 0.5f * (float)std::sin(phase);
+            phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        }
+    }
+
+    static void generateFormantPulses(double sampleRate, float* output, int numSamples)
+    {
+        // Impulse train gliding 110 -> 220 Hz with 5.5 Hz vibrato, through /a/ formant resonators
+        const double formants[] = { 700.0, 1220.0, 2600.0 };
+        const double bandwidths[] = { 110.0, 120.0, 160.0 };
+        double state[3][2] = {};
+        double phase = 1.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double t = (double)i / sampleRate;
+            const double f0 = 110.0 * std::pow(2.0, (double)i / numSamples)
+                              * std::pow(2.0, 0.5 / 12.0 * std::sin(juce::MathConstants<double>::twoPi * 5.5 * t));
+
+            phase += f0 / sampleRate;
+            double sample = 0.0;
+            if (phase >= 1.0)
+            {
+                phase -= 1.0;
+                sample = 1.0;
+            }
+
+            double mixed = 0.0;
+            for (int f = 0; f < 3; ++f)
+            {
+                const double r = std::exp(-juce::MathConstants<double>::pi * bandwidths[f] / sampleRate);
+                const double y = sample + 2.0 * r * std::cos(juce::MathConstants<double>::twoPi * formants[f] / sampleRate) * state[f][0]
+                                 - r * r * state[f][1];
+                state[f][1] = state[f][0];
+                state[f][0] = y;
+                mixed += y * (1.0 - r);
+            }
+
+            output[i] = (float)mixed;
+        }
+
+        const auto range = juce::FloatVectorOperations::findMinAndMax(output, numSamples);
+        const float peak = juce::jmax(-range.getStart(), range.getEnd());
+        if (peak > 0.0f)
+            juce::FloatVectorOperations::multiply(output, 0.5f / peak, numSamples);
+    }
+
+    void generate(Type type, double sampleRate, juce::AudioBuffer<float>& buffer)
+    {
+        const int numSamples = buffer.getNumSamples();
+        auto* output = buffer.getWritePointer(0);
+
+        switch (type)
+        {
+            case Type::sineSweep:
+                generateSweep(sampleRate, output, numSamples);
+                break;
+
+            case Type::formantPulses:
+                generateFormantPulses(sampleRate, output, numSamples);
+                break;
+
+            case Type::noise:
+            {
+                juce::Random random(0x5eed);
+                for (int i = 0; i < numSamples; ++i)
+                    output[i] = 0.3f * (2.0f * random.nextFloat() - 1.0f);
+                break;
+            }
+
+            case Type::silence:
+            default:
+                juce::FloatVectorOperations::clear(output, numSamples);
+                break;
+        }
+
+        for (int ch = 1; ch < buffer.getNumChannels(); ++ch)
+            buffer.copyFrom(ch, 0, buffer, 0, 0, numSamples);
+    }
+}
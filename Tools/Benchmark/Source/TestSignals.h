@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    TestSignals.h
+
+    Synthetic inputs for exercising the processor without recorded material.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace TestSignals
+{
+    enum class Type
+    {
+        sineSweep = 0,                      // Exponential sweep across the detector range
+        formantPulses,                      // Gliding glottal pulse train through vowel formants
+        silence,
+        noise,
+        numTypes
+    };
+
+    const char* getName(Type type);
+
+    // Fills every channel of the buffer with the same signal at the given sample rate
+    void generate(Type type, double sampleRate, juce::AudioBuffer<float>& buffer);
+}